@@ -19,6 +19,92 @@ extern int32_t ece391_open (const uint8_t* filename);
 extern int32_t ece391_close (int32_t fd);
 extern int32_t ece391_getargs (uint8_t* buf, int32_t nbytes);
 extern int32_t ece391_vidmap (uint8_t** screen_start);
+extern int32_t ece391_ioctl (int32_t fd, int32_t cmd, int32_t arg);
+struct pollfd;
+extern int32_t ece391_poll (struct pollfd* fds, int32_t nfds, int32_t timeout);
+extern int32_t ece391_pipe (int32_t* fds);
+extern int32_t ece391_dup2 (int32_t old_fd, int32_t new_fd);
+extern int32_t ece391_spawn (const uint8_t* command);
+extern int32_t ece391_shmget (const uint8_t* name);
+extern int32_t ece391_shmat (int32_t id, uint8_t** addr);
+extern int32_t ece391_shmdt (int32_t id);
+extern int32_t ece391_futex_wait (uint32_t* uaddr, uint32_t val);
+extern int32_t ece391_futex_wake (uint32_t* uaddr, int32_t n);
+/* entry(arg) runs on stack_top in this process's memory and ends with
+ * ece391_halt, which ends only the thread; entry must not return */
+extern int32_t ece391_thread_create (void (*entry)(void*), void* arg, uint8_t* stack_top);
+extern int32_t ece391_wait (int32_t pid, int32_t* status, int32_t options);
+extern int32_t ece391_fork (void);
+extern int32_t ece391_brk (uint32_t end);
+extern int32_t ece391_mmap (uint32_t length, int32_t fd, uint32_t offset);
+extern int32_t ece391_munmap (uint32_t addr, uint32_t length);
+extern int32_t ece391_sendfile (int32_t out_fd, int32_t in_fd, int32_t count);
+extern int32_t ece391_lseek (int32_t fd, int32_t offset, int32_t whence);
+extern int32_t ece391_pread (int32_t fd, void* buf, int32_t nbytes, uint32_t offset);
+extern int32_t ece391_pwrite (int32_t fd, const void* buf, int32_t nbytes, uint32_t offset);
+struct stat;
+extern int32_t ece391_stat (const uint8_t* filename, struct stat* buf);
+extern int32_t ece391_fstat (int32_t fd, struct stat* buf);
+struct dirent;
+extern int32_t ece391_getdents (int32_t fd, struct dirent* buf, int32_t nbytes);
+
+/* ioctl commands for the terminal (fd 0 or 1) */
+#define TERM_SETMODE    1
+#define TERM_GETMODE    2
+#define TERM_MODE_CANON 0   /* line editing and echo, read returns a line */
+#define TERM_MODE_RAW   1   /* no echo, read returns keys as they come */
+
+/* ioctl commands for any fd */
+#define F_GETFL         0x100
+#define F_SETFL         0x101
+#define O_NONBLOCK      0x1 /* read/write return -EAGAIN instead of waiting */
+#define EAGAIN          11
+
+/* every shared memory segment is this many bytes, at the same address in each process */
+#define SHM_SIZE        0x400000
+
+/* ece391_wait collects a spawned child's halt status, pid -1 for any child.
+ * It returns the pid, or -1 if there is no such child. */
+#define WNOHANG         0x1 /* return 0 instead of sleeping if none has halted */
+
+/* ece391_lseek moves a file's position, offset counting from: */
+#define SEEK_SET        0       /* the start of the file */
+#define SEEK_CUR        1       /* the current position */
+#define SEEK_END        2       /* the end of the file */
+
+/* ece391_poll waits until one of the fds is ready or timeout ms pass
+ * (-1 waits forever, 0 only checks), and returns how many are ready */
+#define POLLIN          0x1     /* read will not block */
+#define POLLOUT         0x4     /* write will not block */
+#define POLLNVAL        0x20    /* fd is not open */
+
+struct pollfd {
+    int32_t fd;
+    int16_t events;
+    int16_t revents;        /* filled in by the kernel */
+};
+
+/* what ece391_stat and ece391_fstat fill in */
+#define STAT_RTC        0
+#define STAT_DIR        1
+#define STAT_FILE       2
+#define STAT_DEV        3       /* a device, terminal or pipe */
+
+struct stat {
+    uint32_t size;          /* bytes, 0 for anything but a file */
+    uint32_t type;
+    uint32_t inode;
+    uint32_t blocks;        /* 4kB data blocks */
+};
+
+/* ece391_getdents fills its buffer with as many of these as fit and returns
+ * the bytes used, 0 at the end of the directory */
+struct dirent {
+    uint32_t inode;
+    uint32_t size;          /* bytes, 0 for anything but a file */
+    uint32_t type;          /* STAT_RTC, STAT_DIR or STAT_FILE */
+    uint8_t name[33];       /* always 0 terminated */
+};
 
 #endif /* ECE391SYSCALL_H */
 
@@ -8,6 +8,7 @@
 uint8_t *vmem_base_addr;
 uint8_t *mp1_set_video_mode (void);
 void add_frames(uint8_t *, uint8_t *, int32_t);
+int32_t swim(int32_t rtc_fd, int32_t ticks);
 void ece391_memset(void* memory, char c, int n);
 int32_t ece391_memcpy(void* dest, const void* src, int32_t n);
 
@@ -22,11 +23,14 @@ static struct mp1_blink_struct blink_array[80*25];
 
 int main(void)
 {
-    int rtc_fd, ret_val, i, garbage;
+    int rtc_fd, ret_val;
     struct mp1_blink_struct blink_struct;
 
     ece391_memset(blink_array, 0, sizeof(struct mp1_blink_struct)*80*25);
 
+    /* keys typed while the fish swims should not be echoed over it */
+    ece391_ioctl(0, TERM_SETMODE, TERM_MODE_RAW);
+
     if(mp1_set_video_mode() == NULL) {
         return -1;
     }
@@ -38,10 +42,8 @@ int main(void)
     ret_val = 32;
     ret_val = ece391_write(rtc_fd, &ret_val, 4);
 
-    for(i=0; i<WAIT; i++) {
-        ece391_read(rtc_fd, &garbage, 4);
-        mp1_rtc_tasklet(garbage);
-    }
+    if(swim(rtc_fd, WAIT) == -1)
+        goto done;
 
     blink_struct.on_char = 'I';
     blink_struct.off_char = 'M';
@@ -51,30 +53,54 @@ int main(void)
 
     mp1_ioctl((unsigned long)&blink_struct, RTC_ADD);
 
-    for(i=0; i<WAIT; i++) {
-        ece391_read(rtc_fd, &garbage, 4);
-        mp1_rtc_tasklet(garbage);
-    }
+    if(swim(rtc_fd, WAIT) == -1)
+        goto done;
 
     mp1_ioctl((40 << 16 | (6*80+60)), RTC_SYNC);
 
-    for(i=0; i<WAIT; i++) {
-        ece391_read(rtc_fd, &garbage, 4);
-        mp1_rtc_tasklet(garbage);
-    }
+    if(swim(rtc_fd, WAIT) == -1)
+        goto done;
 
     mp1_ioctl(6*80+60, RTC_REMOVE);
 
-    for(i=0; i<WAIT; i++) {
-        ece391_read(rtc_fd, &garbage, 4);
-        mp1_rtc_tasklet(garbage);
-    }
+    swim(rtc_fd, WAIT);
 
+done:
     ece391_close(rtc_fd);
 
     return 0;
 }
 
+/*
+ * Runs the animation for a number of RTC ticks, sleeping in poll on both
+ * the keyboard and the RTC. Returns -1 as soon as q is pressed.
+ */
+int32_t
+swim(int32_t rtc_fd, int32_t ticks)
+{
+    struct pollfd fds[2];
+    int32_t garbage;
+    uint8_t c;
+
+    fds[0].fd = 0;
+    fds[0].events = POLLIN;
+    fds[1].fd = rtc_fd;
+    fds[1].events = POLLIN;
+
+    while(ticks > 0) {
+        if(ece391_poll(fds, 2, -1) <= 0)
+            return -1;
+        if((fds[0].revents & POLLIN) && ece391_read(0, &c, 1) == 1 && c == 'q')
+            return -1;
+        if(fds[1].revents & POLLIN) {
+            ece391_read(rtc_fd, &garbage, 4);
+            mp1_rtc_tasklet(garbage);
+            ticks--;
+        }
+    }
+    return 0;
+}
+
 void
 add_frames(uint8_t *f0, uint8_t *f1, int32_t rtc_fd)
 {
@@ -9,6 +9,8 @@ extern void rtc_handler_linkage();
 extern void system_call_linkage();
 extern void pit_handler_linkage();
 extern void mouse_handler_linkage();
+extern void serial_handler_linkage();
+extern void page_fault_linkage();
 
 #endif /* ASM */
 
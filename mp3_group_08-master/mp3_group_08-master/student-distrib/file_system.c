@@ -126,7 +126,7 @@ int32_t read_data(uint32_t inode, uint32_t offset, uint8_t* buf, uint32_t length
     data_block_offset = offset % BLOCK_BYTE_SIZE;
 
     //offset is out of bounds, return 0
-    if (data_block_num_idx >= 1023) return 0;
+    if (data_block_num_idx >= 1023 || offset >= file_size) return 0;
 
     data_block_idx = curr_inode->data_block_num[data_block_num_idx];
 
@@ -175,6 +175,28 @@ int32_t get_file_size(uint32_t inode) {
 }
 
 
+/* file_block
+ * 
+ * Finds a data block of a file in the file system image.
+ * Inputs: inode -- the inode number of the file
+ *         index -- which block of the file, counting from 0
+ * Outputs: the block, or NULL if the file has no such block
+ * Side Effects: None
+ */
+data_block_t* file_block(uint32_t inode, uint32_t index) {
+    inode_t* curr;
+    int32_t data_block_idx;
+
+    if (inode >= inodes_num || index >= 1023) return NULL;
+    curr = inode_ptr + inode;
+    if (index * BLOCK_BYTE_SIZE >= curr->length) return NULL; // past the end of the file
+
+    data_block_idx = curr->data_block_num[index];
+    if (data_block_idx < 0 || data_block_idx >= data_blocks_num) return NULL;
+    return data_block_ptr + data_block_idx;
+}
+
+
 // FILE SYSTEM DRIVER FOR FILES
 
 /* file_open
@@ -245,9 +267,9 @@ int32_t file_read(int32_t fd, void* buf, int32_t nbytes){
 
     uint32_t num_bytes_read;
 
-    int8_t pid = pid_arr[(uint8_t)terminal_process_index];
+    int8_t pid = current_pid;
 
-    fda_entry_t* curr_file = &pcb_array[(uint8_t)pid]->fdarray[fd];
+    fda_entry_t* curr_file = &pcb_array[(uint8_t)pid]->proc->fdarray[fd];
     
     num_bytes_read = read_data(curr_file->inode_num, curr_file->file_pos, buf, nbytes);  // read the file data, and check the number of bytes read
 
@@ -329,9 +351,9 @@ int32_t directory_read(int32_t fd, void* buf, int32_t nbytes){
     if (buf == NULL) return -1;   // check for NULL buffer
     if (fd < 0 || fd >= 8) return -1;  // check fd index
 
-    int8_t pid = pid_arr[(uint8_t)terminal_process_index];
+    int8_t pid = current_pid;
 
-    fda_entry_t* curr_file = &pcb_array[(uint8_t)pid]->fdarray[fd];
+    fda_entry_t* curr_file = &pcb_array[(uint8_t)pid]->proc->fdarray[fd];
     
     //check to see if you reached end of directory
     if(read_dentry_by_index(curr_file->file_pos, &entry) == -1) return 0;
@@ -352,3 +374,43 @@ int32_t directory_read(int32_t fd, void* buf, int32_t nbytes){
 
     return read;  // return number of bytes read
 }
+
+
+/* directory_getdents
+ * 
+ * reads as many entries from the directory as fit in the buffer, so a whole
+ * listing takes one call
+ * Inputs: fd -- file descriptor index of the directory we are reading from
+ *          buf -- entries we fill in
+ *          nbytes -- size of buf in bytes
+ * Outputs: returns the bytes filled in, a multiple of sizeof(dirent_t), 0 at
+ *          the end of the directory, or -1 if fd is invalid or buf cannot
+ *          hold even one entry
+ * Side Effects: moves the directory position past the entries read
+ */
+int32_t directory_getdents(int32_t fd, dirent_t* buf, int32_t nbytes){
+    int32_t filled = 0;
+    dentry_t entry;
+    fda_entry_t* curr_file;
+
+    if (buf == NULL || nbytes < 0) return -1;
+    if (fd < 0 || fd >= 8) return -1;  // check fd index
+
+    curr_file = &pcb_array[(uint8_t)current_pid]->proc->fdarray[fd];
+
+    while (read_dentry_by_index(curr_file->file_pos, &entry) == 0) {
+        if (filled + (int32_t)sizeof(dirent_t) > nbytes) {
+            return filled ? filled : -1;  // the rest waits for the next call
+        }
+        buf->inode = entry.inode_num;
+        buf->type = entry.filetype;
+        buf->size = (entry.filetype == 2) ? get_file_size(entry.inode_num) : 0;
+        memcpy(buf->name, entry.filename, FILENAME_LEN);  // not terminated when it is FILENAME_LEN long
+        buf->name[FILENAME_LEN] = '\0';
+
+        buf++;
+        filled += sizeof(dirent_t);
+        curr_file->file_pos++;
+    }
+    return filled;
+}
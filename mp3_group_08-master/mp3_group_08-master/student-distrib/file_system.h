@@ -56,6 +56,9 @@ int32_t read_data(uint32_t inode, uint32_t offset, uint8_t* buf, uint32_t length
 /* rteurns the size of the file corresponding to the inode*/
 int32_t get_file_size(uint32_t inode);
 
+/* finds a data block of a file, for mapping it in place */
+data_block_t* file_block(uint32_t inode, uint32_t index);
+
 /* initializes variables for current file*/
 int32_t file_open(const uint8_t* filename);
 
@@ -80,4 +83,7 @@ int32_t directory_write(int32_t fd, const void* buf, int32_t nbytes);
 /* raeds the filenames inisde of the opened directory*/
 int32_t directory_read(int32_t fd, void* buf, int32_t nbytes);
 
+/* reads as many directory entries as fit, with their types, inodes and sizes */
+int32_t directory_getdents(int32_t fd, dirent_t* buf, int32_t nbytes);
+
 #endif
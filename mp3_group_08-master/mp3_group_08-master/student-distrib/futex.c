@@ -0,0 +1,98 @@
+#include "futex.h"
+#include "lib.h"
+#include "paging.h"
+#include "system_calls.h"
+#include "wait_queue.h"
+
+/* everybody in a futex_wait sleeps on this one queue, futex_key says which
+ * word each of them is waiting on. There are so few processes that looking
+ * through all of them beats hashing */
+static wait_queue_t futex_waiters;
+uint32_t futex_key[MAX_PROCESSES]; // physical address, 0 when not waiting
+
+/* futex_lookup
+ * 
+ * resolves the word as a write would, otherwise a copy-on-write page shared
+ * since fork would give parent and child the same key until one of them stores to it
+ * Inputs: uaddr -- user address of a 32 bit word
+ * Outputs: its physical address, the key shared by every mapping of the word, 0 if it is not a valid word
+ * Side Effects: None
+ */
+uint32_t futex_lookup(uint32_t* uaddr){
+    if(current_pid < 0 || ((uint32_t)uaddr & 0x3) || user_page_touch_write((uint32_t)uaddr)){
+        return 0;
+    }
+    return user_virt_to_phys((uint32_t)uaddr);
+}
+
+/* futex_wait
+ * 
+ * the compare and the sleep happen with interrupts off, so a futex_wake after
+ * the word changed cannot slip in between them and be lost
+ * Inputs: uaddr -- word to wait on, val -- what the caller last saw in it
+ * Outputs: 0 when woken by futex_wake, -EAGAIN if *uaddr != val, -1 on a bad address
+ * Side Effects: sleeps
+ */
+int32_t futex_wait(uint32_t* uaddr, uint32_t val){
+    uint32_t key = futex_lookup(uaddr);
+    uint32_t flags;
+    int8_t pid = current_pid;
+
+    if(key == 0){
+        return -1;
+    }
+
+    cli_and_save(flags);
+    if(*uaddr != val){
+        restore_flags(flags);
+        return -EAGAIN;
+    }
+    futex_key[(uint8_t)pid] = key;
+    while(futex_key[(uint8_t)pid] == key){ // other wakeups of the shared queue are spurious
+        wait_queue_sleep(&futex_waiters);
+    }
+    restore_flags(flags);
+    return 0;
+}
+
+/* futex_wake
+ * 
+ * Inputs: uaddr -- word that changed, n -- most processes to wake
+ * Outputs: number woken, -1 on a bad address
+ * Side Effects: None
+ */
+int32_t futex_wake(uint32_t* uaddr, int32_t n){
+    uint32_t key = futex_lookup(uaddr);
+    uint32_t flags;
+    int32_t pid, woken = 0;
+
+    if(key == 0 || n < 0){
+        return -1;
+    }
+
+    cli_and_save(flags);
+    for(pid = 0; pid < MAX_PROCESSES && woken < n; pid++){
+        if(futex_key[pid] == key){
+            futex_key[pid] = 0;
+            woken++;
+        }
+    }
+    if(woken > 0){
+        wake_up(&futex_waiters); // the rest find their key unchanged and sleep again
+    }
+    restore_flags(flags);
+    return woken;
+}
+
+/* futex_cancel
+ * 
+ * a process ended in futex_wait would otherwise soak up a futex_wake meant for a live waiter
+ * Inputs: pid -- process being ended
+ * Outputs: None
+ * Side Effects: None
+ */
+void futex_cancel(int32_t pid){
+    if(pid >= 0 && pid < MAX_PROCESSES){
+        futex_key[pid] = 0;
+    }
+}
@@ -0,0 +1,23 @@
+#ifndef _FUTEX_H
+#define _FUTEX_H
+
+#include "types.h"
+#include "system_calls.h"
+
+/* the word each pid sleeps on in futex_wait, by futex_lookup key, 0 when it is not waiting */
+extern uint32_t futex_key[MAX_PROCESSES];
+
+/* physical address of the user word at uaddr, the key every mapping of it shares, 0 if it is not a valid word */
+uint32_t futex_lookup(uint32_t* uaddr);
+
+/* sleeps while the user word at uaddr holds val, returns 0 once woken,
+ * -EAGAIN if it already changed, -1 for a bad address */
+int32_t futex_wait(uint32_t* uaddr, uint32_t val);
+
+/* wakes up to n processes waiting on uaddr, returns how many */
+int32_t futex_wake(uint32_t* uaddr, int32_t n);
+
+/* drops whatever pid was waiting on, it is being ended in its sleep */
+void futex_cancel(int32_t pid);
+
+#endif /* _FUTEX_H */
@@ -0,0 +1,144 @@
+#include "history.h"
+#include "lib.h"
+
+#define HISTORY_MASK (HISTORY_DEPTH - 1)
+
+/* history_init
+ *
+ * empties a history
+ * Inputs: h -- history to reset
+ * Outputs: None
+ * Side Effects: None
+ */
+void history_init(history_t* h){
+    if (h == NULL) return;
+    h->head = 0;
+    h->pos = 0;
+    h->draft_len = 0;
+    h->searching = 0;
+    h->query_len = 0;
+    h->match = 0;
+}
+
+/* history_add
+ *
+ * copies a finished line into the next slot, overwriting the oldest once full
+ * Inputs: h -- history to add to
+ *         line -- the line, no newline
+ *         len -- its length
+ * Outputs: None
+ * Side Effects: Up/Down start over from the newest line
+ */
+void history_add(history_t* h, const char* line, uint32_t len){
+    uint32_t slot;
+    if (h == NULL || line == NULL) return;
+    h->pos = 0;
+    if (len == 0) return;
+    if (len > HISTORY_LINE_SIZE - 1) len = HISTORY_LINE_SIZE - 1;
+
+    slot = h->head & HISTORY_MASK;
+    memcpy(h->line[slot], line, len);
+    h->line[slot][len] = '\0';
+    h->len[slot] = len;
+    h->head++;
+}
+
+/* history_count
+ *
+ * Inputs: h -- history
+ * Outputs: number of lines that can be recalled
+ * Side Effects: None
+ */
+uint32_t history_count(history_t* h){
+    return (h->head < HISTORY_DEPTH) ? h->head : HISTORY_DEPTH;
+}
+
+/* history_get
+ *
+ * copies a line out of the history, NUL terminated
+ * Inputs: h -- history
+ *         back -- how many lines ago, 1 is the newest
+ *         out -- HISTORY_LINE_SIZE bytes
+ * Outputs: length of the line, -1 if there is no such line
+ * Side Effects: None
+ */
+int32_t history_get(history_t* h, uint32_t back, char* out){
+    uint32_t slot;
+    if (h == NULL || out == NULL || back == 0 || back > history_count(h)) return -1;
+
+    slot = (h->head - back) & HISTORY_MASK;
+    memcpy(out, h->line[slot], h->len[slot] + 1);
+    return h->len[slot];
+}
+
+/* history_prev
+ *
+ * steps one line older, the first step saves the line being typed
+ * Inputs: h -- history
+ *         cur -- line currently being typed
+ *         cur_len -- its length
+ *         out -- HISTORY_LINE_SIZE bytes for the older line
+ * Outputs: length of the line put in out, -1 if already at the oldest
+ * Side Effects: None
+ */
+int32_t history_prev(history_t* h, const char* cur, uint32_t cur_len, char* out){
+    if (h == NULL || h->pos >= history_count(h)) return -1;
+
+    if (h->pos == 0) {
+        if (cur_len > HISTORY_LINE_SIZE - 1) cur_len = HISTORY_LINE_SIZE - 1;
+        memcpy(h->draft, cur, cur_len);
+        h->draft[cur_len] = '\0';
+        h->draft_len = cur_len;
+    }
+    h->pos++;
+    return history_get(h, h->pos, out);
+}
+
+/* history_next
+ *
+ * steps one line newer, stepping past the newest gives back the saved line
+ * Inputs: h -- history
+ *         out -- HISTORY_LINE_SIZE bytes for the newer line
+ * Outputs: length of the line put in out, -1 if not browsing
+ * Side Effects: None
+ */
+int32_t history_next(history_t* h, char* out){
+    if (h == NULL || h->pos == 0) return -1;
+
+    h->pos--;
+    if (h->pos == 0) {
+        memcpy(out, h->draft, h->draft_len + 1);
+        return h->draft_len;
+    }
+    return history_get(h, h->pos, out);
+}
+
+/* history_search
+ *
+ * scans from start lines back towards older lines for one containing query,
+ * typing another character searches again from the current match so the
+ * search narrows without starting over
+ * Inputs: h -- history
+ *         query -- string to look for
+ *         query_len -- its length, 0 matches any line
+ *         start -- first line to look at, 1 is the newest
+ * Outputs: how far back the match is, -1 if nothing older matches
+ * Side Effects: None
+ */
+int32_t history_search(history_t* h, const char* query, uint32_t query_len, uint32_t start){
+    uint32_t back, i, count;
+    if (h == NULL || query == NULL) return -1;
+    if (start == 0) start = 1;
+
+    count = history_count(h);
+    for (back = start; back <= count; back++) {
+        uint32_t slot = (h->head - back) & HISTORY_MASK;
+        if (query_len > h->len[slot]) continue;
+        for (i = 0; i + query_len <= h->len[slot]; i++) {
+            if (strncmp(&h->line[slot][i], query, query_len) == 0) {
+                return back;
+            }
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,44 @@
+#ifndef _HISTORY_H
+#define _HISTORY_H
+
+#include "types.h"
+
+#define HISTORY_DEPTH       32      // commands kept per terminal, must be a power of 2
+#define HISTORY_LINE_SIZE   128     // same as the keyboard buffer
+#define HISTORY_QUERY_SIZE  32      // longest Ctrl+R search string
+
+/* a terminal's command history, lines go in a circular array of slots so
+ * adding one only copies that line */
+typedef struct history_t {
+    char line[HISTORY_DEPTH][HISTORY_LINE_SIZE];
+    uint8_t len[HISTORY_DEPTH];
+    uint32_t head;      // total lines ever added, newest is head - 1
+    uint32_t pos;       // how far back Up/Down is, 0 is the line being typed
+    char draft[HISTORY_LINE_SIZE]; // the line being typed before Up was pressed
+    uint32_t draft_len;
+    uint8_t searching;  // in a Ctrl+R search
+    char query[HISTORY_QUERY_SIZE];
+    uint32_t query_len;
+    uint32_t match;     // how far back the current search match is, 0 for none
+} history_t;
+
+/* empties a history */
+void history_init(history_t* h);
+
+/* adds a finished line, empty lines are skipped */
+void history_add(history_t* h, const char* line, uint32_t len);
+
+/* number of lines currently held */
+uint32_t history_count(history_t* h);
+
+/* copies the line back lines ago (1 is the newest) into out, returns its length or -1 */
+int32_t history_get(history_t* h, uint32_t back, char* out);
+
+/* steps one line older/newer, cur is the line being typed so Down can give it back */
+int32_t history_prev(history_t* h, const char* cur, uint32_t cur_len, char* out);
+int32_t history_next(history_t* h, char* out);
+
+/* finds the newest line at least start lines back that contains query, returns how far back or -1 */
+int32_t history_search(history_t* h, const char* query, uint32_t query_len, uint32_t start);
+
+#endif /* _HISTORY_H */
@@ -1,4 +1,6 @@
 #include "idt.h"
+#include "paging.h"
+#include "klog.h"
 
 // Local Function Declarations
 static void exception_handler();
@@ -16,7 +18,6 @@ static void invalid_tss_exception();
 static void segment_not_present_exception();
 static void stack_fault_exception();
 static void general_protection_exception();
-static void page_fault_exception();
 // EXCEPTION 15 RESERVED
 static void x87_floating_point_exception();
 static void alignment_check_exception();
@@ -74,7 +75,7 @@ void int_idt(){
     SET_IDT_ENTRY(idt[0x0B], segment_not_present_exception);
     SET_IDT_ENTRY(idt[0x0C], stack_fault_exception);
     SET_IDT_ENTRY(idt[0x0D], general_protection_exception);
-    SET_IDT_ENTRY(idt[0x0E], page_fault_exception);
+    SET_IDT_ENTRY(idt[0x0E], page_fault_linkage);  // needs the error code and to return after copy-on-write
 
     SET_IDT_ENTRY(idt[0x0F], exception_handler);
     SET_IDT_ENTRY(idt[0x10], x87_floating_point_exception);
@@ -84,6 +85,7 @@ void int_idt(){
 
     SET_IDT_ENTRY(idt[0x20], pit_handler_linkage);
     SET_IDT_ENTRY(idt[0x21], keyboard_handler_linkage);    // need assembly linkage
+    SET_IDT_ENTRY(idt[0x24], serial_handler_linkage);    // COM1
     SET_IDT_ENTRY(idt[0x28], rtc_handler_linkage);    // need assembly linkage
     SET_IDT_ENTRY(idt[0x2C], mouse_handler_linkage);
 
@@ -102,10 +104,10 @@ void int_idt(){
  * general exception handler
  * Inputs: None
  * Outputs: None
- * Side Effects: prints exception handler, loops infinitely 
+ * Side Effects: logs exception handler, loops infinitely 
  */
 static void exception_handler(){
-    printf("exception handler \n");
+    klog_panic("exception handler \n");
     while(1);
     return;
 }
@@ -115,10 +117,10 @@ static void exception_handler(){
  * divide zero exception handler
  * Inputs: None
  * Outputs: None
- * Side Effects: prints divide zero exception, loops infinitely 
+ * Side Effects: logs divide zero exception, loops infinitely 
  */
 static void divide_zero_exception(){  // exception 0
-    printf("Divide Zero Exception\n");
+    klog_panic("Divide Zero Exception\n");
     while(1);
     return;
 }
@@ -128,10 +130,10 @@ static void divide_zero_exception(){  // exception 0
  * debug exception handler
  * Inputs: None
  * Outputs: None
- * Side Effects: prints debug exception, loops infinitely 
+ * Side Effects: logs debug exception, loops infinitely 
  */
 static void debug_exception(){  // exception 1
-    printf("Debug Exception \n");
+    klog_panic("Debug Exception \n");
     while(1);
     return;
 }
@@ -141,10 +143,10 @@ static void debug_exception(){  // exception 1
  * nmi interrupt handler
  * Inputs: None
  * Outputs: None
- * Side Effects: prints NMI interrupt, loops infinitely 
+ * Side Effects: logs NMI interrupt, loops infinitely 
  */
 static void nmi_interrupt(){  // exception 2
-    printf("NMI Interrupt \n");
+    klog_panic("NMI Interrupt \n");
     while(1);
     return;
 }
@@ -154,10 +156,10 @@ static void nmi_interrupt(){  // exception 2
  * breakpoint exception handler
  * Inputs: None
  * Outputs: None
- * Side Effects: prints breakpoint exception, loops infinitely 
+ * Side Effects: logs breakpoint exception, loops infinitely 
  */
 static void breakpoint_exception(){  // exception 3
-    printf("Breakpoint Exception \n");
+    klog_panic("Breakpoint Exception \n");
     while(1);
     return;
 }
@@ -167,10 +169,10 @@ static void breakpoint_exception(){  // exception 3
  * overflow exception handler
  * Inputs: None
  * Outputs: None
- * Side Effects: prints overflow exception, loops infinitely 
+ * Side Effects: logs overflow exception, loops infinitely 
  */
 static void overflow_exception(){  // exception 4
-    printf("Overflow Exception \n");
+    klog_panic("Overflow Exception \n");
     while(1);
     return;
 }
@@ -180,10 +182,10 @@ static void overflow_exception(){  // exception 4
  * bound range exceeded exception handler
  * Inputs: None
  * Outputs: None
- * Side Effects: prints bound range exceeded exception, loops infinitely 
+ * Side Effects: logs bound range exceeded exception, loops infinitely 
  */
 static void bound_range_exceeded_exception(){  // exception 5
-    printf("Bound Range Exceeded Exception \n");
+    klog_panic("Bound Range Exceeded Exception \n");
     while(1);
     return;
 }
@@ -193,10 +195,10 @@ static void bound_range_exceeded_exception(){  // exception 5
  * invalid opcode exception handler
  * Inputs: None
  * Outputs: None
- * Side Effects: prints invalid opcode exception, loops infinitely 
+ * Side Effects: logs invalid opcode exception, loops infinitely 
  */
 static void invalid_opcode_exception(){  // exception 6
-    printf("Invalid Opcode Exception \n");
+    klog_panic("Invalid Opcode Exception \n");
     while(1);
     return;
 }
@@ -206,10 +208,10 @@ static void invalid_opcode_exception(){  // exception 6
  * device not available exception handler
  * Inputs: None
  * Outputs: None
- * Side Effects: prints device not available exception, loops infinitely 
+ * Side Effects: logs device not available exception, loops infinitely 
  */
 static void device_not_available_exception(){  // exception 7
-    printf("Device Not Available Exception \n");
+    klog_panic("Device Not Available Exception \n");
     while(1);
     return;
 }
@@ -219,10 +221,10 @@ static void device_not_available_exception(){  // exception 7
  * double fault exception handler
  * Inputs: None
  * Outputs: None
- * Side Effects: prints double fault exception, loops infinitely 
+ * Side Effects: logs double fault exception, loops infinitely 
  */
 static void double_fault_exception(){  // exception 8
-    printf("Double Fault Exception \n");
+    klog_panic("Double Fault Exception \n");
     while(1);
     return;
 }
@@ -232,10 +234,10 @@ static void double_fault_exception(){  // exception 8
  * coprocessor segment overrun exception handler
  * Inputs: None
  * Outputs: None
- * Side Effects: prints coprocessor segment overrun exception, loops infinitely 
+ * Side Effects: logs coprocessor segment overrun exception, loops infinitely 
  */
 static void coprocessor_segment_overrun_exception(){  // exception 9
-    printf("Coprocessor Segment Overrun Exception \n");
+    klog_panic("Coprocessor Segment Overrun Exception \n");
     while(1);
     return;
 }
@@ -245,10 +247,10 @@ static void coprocessor_segment_overrun_exception(){  // exception 9
  * invalid tss exception handler
  * Inputs: None
  * Outputs: None
- * Side Effects: prints invalid tss exception, loops infinitely 
+ * Side Effects: logs invalid tss exception, loops infinitely 
  */
 static void invalid_tss_exception(){  // exception 10
-    printf("Invalid TSS Exception \n");
+    klog_panic("Invalid TSS Exception \n");
     while(1);
     return;
 }
@@ -258,10 +260,10 @@ static void invalid_tss_exception(){  // exception 10
  * segment not present exception handler
  * Inputs: None
  * Outputs: None
- * Side Effects: prints segment not present exception, loops infinitely 
+ * Side Effects: logs segment not present exception, loops infinitely 
  */
 static void segment_not_present_exception(){  // exception 11
-    printf("Segment Not Present Exception \n");
+    klog_panic("Segment Not Present Exception \n");
     while(1);
     return;
 }
@@ -271,10 +273,10 @@ static void segment_not_present_exception(){  // exception 11
  * stack fault exception handler
  * Inputs: None
  * Outputs: None
- * Side Effects: prints stack fault exception, loops infinitely 
+ * Side Effects: logs stack fault exception, loops infinitely 
  */
 static void stack_fault_exception(){  // exception 12
-    printf("Stack Fault Exception \n");
+    klog_panic("Stack Fault Exception \n");
     while(1);
     return;
 }
@@ -284,23 +286,27 @@ static void stack_fault_exception(){  // exception 12
  * general protection exception handler
  * Inputs: None
  * Outputs: None
- * Side Effects: prints general protection exception, loops infinitely 
+ * Side Effects: logs general protection exception, loops infinitely 
  */
 static void general_protection_exception(){  // exception 13
-    printf("General Protection Exception \n");
+    klog_panic("General Protection Exception \n");
     while(1);
     return;
 }
 
 /* page_fault_exception
  * 
- * page fault exception handler
- * Inputs: None
+ * page fault exception handler, faults on lazily zero filled and
+ * copy-on-write pages are resolved and retried
+ * Inputs: addr -- faulting address from cr2, err -- error code the cpu pushed
  * Outputs: None
- * Side Effects: prints page fault exception, loops infinitely 
+ * Side Effects: logs page fault exception and loops infinitely for any other fault
  */
-static void page_fault_exception(){  // exception 14
-    printf("Page Fault Exception \n");
+void page_fault_exception(uint32_t addr, uint32_t err){  // exception 14
+    if(0 == user_page_fault(addr, err)){
+        return;
+    }
+    klog_panic("Page Fault Exception at 0x%x, error 0x%x\n", addr, err);
     while(1);
     return;
 }
@@ -312,10 +318,10 @@ static void page_fault_exception(){  // exception 14
  * x87 floating point exception handler
  * Inputs: None
  * Outputs: None
- * Side Effects: prints x87 FPU floating point error exception, loops infinitely 
+ * Side Effects: logs x87 FPU floating point error exception, loops infinitely 
  */
 static void x87_floating_point_exception(){  // exception 16
-    printf("x87 FPU Floating Point Error Exception \n");
+    klog_panic("x87 FPU Floating Point Error Exception \n");
     while(1);
     return;
 }
@@ -325,10 +331,10 @@ static void x87_floating_point_exception(){  // exception 16
  * alignment check exception handler
  * Inputs: None
  * Outputs: None
- * Side Effects: prints alignment check exception, loops infinitely 
+ * Side Effects: logs alignment check exception, loops infinitely 
  */
 static void alignment_check_exception(){  // exception 17
-    printf("Alignment Check Exception \n");
+    klog_panic("Alignment Check Exception \n");
     while(1);
     return;
 }
@@ -338,10 +344,10 @@ static void alignment_check_exception(){  // exception 17
  * machine check exception handler
  * Inputs: None
  * Outputs: None
- * Side Effects: prints machine check exception, loops infinitely 
+ * Side Effects: logs machine check exception, loops infinitely 
  */
 static void machine_check_exception(){  // exception 18
-    printf("Machine Check Exception \n");
+    klog_panic("Machine Check Exception \n");
     while(1);
     return;
 }
@@ -351,10 +357,10 @@ static void machine_check_exception(){  // exception 18
  * simd floating point exception handler
  * Inputs: None
  * Outputs: None
- * Side Effects: prints simd floating point exception, loops infinitely 
+ * Side Effects: logs simd floating point exception, loops infinitely 
  */
 static void simd_floating_point_exception(){  // exception 19
-    printf("SIMD Floating Point Exception \n");
+    klog_panic("SIMD Floating Point Exception \n");
     while(1);
     return;
 }
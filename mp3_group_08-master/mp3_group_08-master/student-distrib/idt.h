@@ -12,6 +12,8 @@
 
 void int_idt(); //idt initialization function, fills idt table
 
+void page_fault_exception(uint32_t addr, uint32_t err); //called by page_fault_linkage
+
 //extern void keyboard_handler_linkage();
 
 #endif /* _IDT_H */
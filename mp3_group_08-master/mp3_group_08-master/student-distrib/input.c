@@ -0,0 +1,273 @@
+#include "input.h"
+#include "lib.h"
+#include "system_calls.h"
+
+extern int8_t terminal_process_index;
+
+/* events for whoever has the device open on each terminal. Input always goes
+ * to the terminal on screen, same as typing */
+static input_queue_t kbd_queue[3];
+static input_queue_t mouse_queue[3];
+
+/* input_push
+ * 
+ * adds an event to a queue, only called from an IRQ
+ * Inputs: queue, the event
+ * Outputs: None
+ * Side Effects: wakes the readers, counts a drop when the queue is full
+ */
+static void input_push(input_queue_t* q, const input_event_t* ev){
+    if(q->readers == 0){
+        return;
+    }
+    if(q->head - q->tail == INPUT_QUEUE_SIZE){
+        q->dropped++;
+        return;
+    }
+    q->events[q->head & (INPUT_QUEUE_SIZE - 1)] = *ev;
+    asm volatile("" ::: "memory"); //event must be in place before head moves
+    q->head++;
+    wake_up(&q->wq);
+}
+
+/* input_queue_read
+ * 
+ * sleeps until the queue has an event, then copies out as many whole events
+ * as fit in buf
+ * Inputs: queue, user buffer and its size
+ * Outputs: bytes copied, -1 if buf cannot hold one event
+ * Side Effects: other terminals run while this one sleeps
+ */
+static int32_t input_queue_read(input_queue_t* q, void* buf, int32_t nbytes){
+    input_event_t* out = (input_event_t*)buf;
+    uint32_t flags;
+    int32_t n = 0;
+
+    if(buf == NULL || nbytes < (int32_t)sizeof(input_event_t)){
+        return -1;
+    }
+
+    cli_and_save(flags);
+    while(q->head == q->tail){
+        wait_queue_sleep(&q->wq);
+    }
+    restore_flags(flags);
+
+    while(n < nbytes / (int32_t)sizeof(input_event_t) && q->tail != q->head){
+        out[n++] = q->events[q->tail & (INPUT_QUEUE_SIZE - 1)];
+        q->tail++;
+    }
+    return n * sizeof(input_event_t);
+}
+
+/* input_queue_poll
+ * 
+ * Inputs: queue, nonzero to wait on it if it is empty
+ * Outputs: POLLIN if there is an event, else 0
+ * Side Effects: call with interrupts off
+ */
+static int32_t input_queue_poll(input_queue_t* q, int32_t wait){
+    if(q->head != q->tail){
+        return POLLIN;
+    }
+    if(wait){
+        wait_queue_add(&q->wq);
+    }
+    return 0;
+}
+
+/* input_queue_open
+ * 
+ * a new reader starts with an empty queue rather than events that came in
+ * before it asked for them
+ * Inputs: queue
+ * Outputs: 0
+ * Side Effects: None
+ */
+static int32_t input_queue_open(input_queue_t* q){
+    uint32_t flags;
+    cli_and_save(flags);
+    if(q->readers++ == 0){
+        q->tail = q->head;
+    }
+    restore_flags(flags);
+    return 0;
+}
+
+/* input_queue_close
+ * 
+ * Inputs: queue
+ * Outputs: 0
+ * Side Effects: the last close stops events being queued
+ */
+static int32_t input_queue_close(input_queue_t* q){
+    uint32_t flags;
+    cli_and_save(flags);
+    if(q->readers > 0){
+        q->readers--;
+    }
+    restore_flags(flags);
+    return 0;
+}
+
+/* input_report_key
+ * 
+ * queues a scan code for the keyboard device on term
+ * Inputs: terminal, raw scan code, TSC at IRQ entry
+ * Outputs: None
+ * Side Effects: None
+ */
+void input_report_key(uint8_t term, uint8_t code, uint64_t time){
+    input_event_t ev;
+    if(term > 2){
+        return;
+    }
+    memset(&ev, 0, sizeof(ev));
+    ev.time = time;
+    ev.type = INPUT_KEY;
+    ev.code = code;
+    input_push(&kbd_queue[term], &ev);
+}
+
+/* input_report_mouse
+ * 
+ * queues a packet for the mouse device on term
+ * Inputs: terminal, buttons held, motion, TSC at IRQ entry
+ * Outputs: None
+ * Side Effects: None
+ */
+void input_report_mouse(uint8_t term, uint8_t buttons, int16_t dx, int16_t dy, int8_t dz, uint64_t time){
+    input_event_t ev;
+    if(term > 2){
+        return;
+    }
+    memset(&ev, 0, sizeof(ev));
+    ev.time = time;
+    ev.type = INPUT_MOUSE;
+    ev.code = buttons;
+    ev.dx = dx;
+    ev.dy = dy;
+    ev.dz = dz;
+    input_push(&mouse_queue[term], &ev);
+}
+
+/* input_dropped
+ * 
+ * Inputs: terminal, INPUT_KEY or INPUT_MOUSE
+ * Outputs: events lost because the queue was full
+ * Side Effects: None
+ */
+uint32_t input_dropped(uint8_t term, uint8_t type){
+    if(term > 2){
+        return 0;
+    }
+    return (type == INPUT_KEY) ? kbd_queue[term].dropped : mouse_queue[term].dropped;
+}
+
+/* kbd_dev_open
+ * 
+ * starts queueing key events for the opener's terminal
+ * Inputs: filename -- not used
+ * Outputs: 0
+ * Side Effects: None
+ */
+int32_t kbd_dev_open(const uint8_t* filename){
+    return input_queue_open(&kbd_queue[(uint8_t)terminal_process_index]);
+}
+
+/* kbd_dev_close
+ * 
+ * Inputs: fd -- not used
+ * Outputs: 0
+ * Side Effects: None
+ */
+int32_t kbd_dev_close(int32_t fd){
+    return input_queue_close(&kbd_queue[(uint8_t)terminal_process_index]);
+}
+
+/* kbd_dev_read
+ * 
+ * blocks until a key is pressed or released on this terminal
+ * Inputs: fd -- not used
+ *         buf -- room for one or more input_event_t
+ *         nbytes -- size of buf
+ * Outputs: bytes of whole events copied, -1 on bad input
+ * Side Effects: sleeps while there are no events
+ */
+int32_t kbd_dev_read(int32_t fd, void* buf, int32_t nbytes){
+    return input_queue_read(&kbd_queue[(uint8_t)terminal_process_index], buf, nbytes);
+}
+
+/* kbd_dev_poll
+ * 
+ * Inputs: fd -- not used, wait -- nonzero to wait for a key
+ * Outputs: POLLIN if a key event is queued, else 0
+ * Side Effects: None
+ */
+int32_t kbd_dev_poll(int32_t fd, int32_t wait){
+    return input_queue_poll(&kbd_queue[(uint8_t)terminal_process_index], wait);
+}
+
+/* kbd_dev_write
+ * 
+ * Inputs: not used
+ * Outputs: -1, the device is read only
+ * Side Effects: None
+ */
+int32_t kbd_dev_write(int32_t fd, const void* buf, int32_t nbytes){
+    return -1;
+}
+
+/* mouse_dev_open
+ * 
+ * starts queueing mouse events for the opener's terminal
+ * Inputs: filename -- not used
+ * Outputs: 0
+ * Side Effects: None
+ */
+int32_t mouse_dev_open(const uint8_t* filename){
+    return input_queue_open(&mouse_queue[(uint8_t)terminal_process_index]);
+}
+
+/* mouse_dev_close
+ * 
+ * Inputs: fd -- not used
+ * Outputs: 0
+ * Side Effects: None
+ */
+int32_t mouse_dev_close(int32_t fd){
+    return input_queue_close(&mouse_queue[(uint8_t)terminal_process_index]);
+}
+
+/* mouse_dev_read
+ * 
+ * blocks until the mouse moves or a button changes on this terminal
+ * Inputs: fd -- not used
+ *         buf -- room for one or more input_event_t
+ *         nbytes -- size of buf
+ * Outputs: bytes of whole events copied, -1 on bad input
+ * Side Effects: sleeps while there are no events
+ */
+int32_t mouse_dev_read(int32_t fd, void* buf, int32_t nbytes){
+    return input_queue_read(&mouse_queue[(uint8_t)terminal_process_index], buf, nbytes);
+}
+
+/* mouse_dev_poll
+ * 
+ * Inputs: fd -- not used, wait -- nonzero to wait for mouse input
+ * Outputs: POLLIN if a mouse event is queued, else 0
+ * Side Effects: None
+ */
+int32_t mouse_dev_poll(int32_t fd, int32_t wait){
+    return input_queue_poll(&mouse_queue[(uint8_t)terminal_process_index], wait);
+}
+
+/* mouse_dev_write
+ * 
+ * Inputs: not used
+ * Outputs: -1, the device is read only
+ * Side Effects: None
+ */
+int32_t mouse_dev_write(int32_t fd, const void* buf, int32_t nbytes){
+    return -1;
+}
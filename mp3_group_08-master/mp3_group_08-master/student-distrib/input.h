@@ -0,0 +1,57 @@
+#ifndef _INPUT_H
+#define _INPUT_H
+
+#include "types.h"
+#include "wait_queue.h"
+
+#define INPUT_QUEUE_SIZE    64      // events buffered per terminal and device, must be a power of 2
+
+#define INPUT_KEY           1       // code is the raw scan code, bit 7 set on release
+#define INPUT_MOUSE         2       // code is the MOUSE_BUTTONS bits, dx/dy/dz the motion
+
+/* one event as read() hands it out, 16 bytes so a read never splits one */
+typedef struct input_event_t {
+    uint64_t time;      // TSC when the IRQ that produced it came in
+    uint8_t type;       // INPUT_KEY or INPUT_MOUSE
+    uint8_t code;
+    int8_t dz;          // mouse wheel
+    uint8_t reserved;
+    int16_t dx;         // mouse motion, right is positive
+    int16_t dy;         // mouse motion, up is positive
+} input_event_t;
+
+/* events waiting for the readers of one device on one terminal. The IRQ is
+ * the only producer and the reading process the only consumer */
+typedef struct input_queue_t {
+    input_event_t events[INPUT_QUEUE_SIZE];
+    volatile uint32_t head;     // total events ever pushed
+    volatile uint32_t tail;     // total events ever taken
+    uint32_t dropped;           // events lost to a full queue
+    uint32_t readers;           // open fds, nothing is queued without one
+    wait_queue_t wq;            // woken by every push
+} input_queue_t;
+
+/* called by the keyboard IRQ for every scan code, presses and releases */
+void input_report_key(uint8_t term, uint8_t code, uint64_t time);
+
+/* called by the mouse IRQ for every finished packet */
+void input_report_mouse(uint8_t term, uint8_t buttons, int16_t dx, int16_t dy, int8_t dz, uint64_t time);
+
+/* events lost on term's queue for a device (INPUT_KEY or INPUT_MOUSE) */
+uint32_t input_dropped(uint8_t term, uint8_t type);
+
+/* file operations for the "keyboard" device */
+int32_t kbd_dev_open(const uint8_t* filename);
+int32_t kbd_dev_close(int32_t fd);
+int32_t kbd_dev_read(int32_t fd, void* buf, int32_t nbytes);
+int32_t kbd_dev_write(int32_t fd, const void* buf, int32_t nbytes);
+int32_t kbd_dev_poll(int32_t fd, int32_t wait);
+
+/* file operations for the "mouse" device */
+int32_t mouse_dev_open(const uint8_t* filename);
+int32_t mouse_dev_close(int32_t fd);
+int32_t mouse_dev_read(int32_t fd, void* buf, int32_t nbytes);
+int32_t mouse_dev_write(int32_t fd, const void* buf, int32_t nbytes);
+int32_t mouse_dev_poll(int32_t fd, int32_t wait);
+
+#endif /* _INPUT_H */
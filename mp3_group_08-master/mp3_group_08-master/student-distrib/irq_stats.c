@@ -0,0 +1,312 @@
+#include "irq_stats.h"
+#include "lib.h"
+#include "system_calls.h"
+
+#define IRQ_REPORT_SIZE     4096    // room for the text report of every line
+#define IRQ_REPORT_SLOTS    4       // open irqstats fds that can hold a report at once
+
+/* the report one irqstats fd is reading, made when it reads from offset 0 */
+typedef struct irq_report_t {
+    int8_t text[IRQ_REPORT_SIZE];
+    uint32_t len;
+    uint32_t refs;                  // fds using it, free at 0
+} irq_report_t;
+
+/* written directly by the assembly linkage on every interrupt entry */
+uint64_t irq_entry_tsc[IRQ_STATS_NUM] __attribute__((aligned(8)));
+
+static irq_stats_t irq_stats[IRQ_STATS_NUM];
+
+static irq_report_t irq_reports[IRQ_REPORT_SLOTS];
+static irq_report_t* report_target[MAX_PROCESSES]; // report each pid is formatting into
+
+/* irq_stats_record
+ * 
+ * folds one handler run into the stats for its IRQ. Called from the CREATE_HANDLER
+ * linkage with the TSC read right after the C handler returned. The entry stamp is
+ * kept per IRQ instead of on the stack so the PIT handler, which can come back on
+ * a different kernel stack after schedule(), still pairs with its own entry.
+ * Inputs: irq -- PIC line of the handler that ran
+ *         exit_tsc -- TSC value taken after the handler returned
+ * Outputs: None
+ * Side Effects: updates count, max, gap and histogram for irq
+ */
+void irq_stats_record(uint32_t irq, uint64_t exit_tsc){
+    irq_stats_t* stats;
+    uint64_t entry, elapsed, gap;
+    uint32_t cycles, bucket, v, flags;
+
+    if (irq >= IRQ_STATS_NUM) return;
+
+    cli_and_save(flags); // the handler may have re-enabled interrupts
+    stats = &irq_stats[irq];
+    entry = irq_entry_tsc[irq];
+    elapsed = exit_tsc - entry;
+    cycles = (elapsed >> 32) ? 0xFFFFFFFF : (uint32_t)elapsed; // clamp to 32 bits
+
+    stats->count++;
+    stats->total_cycles += elapsed;
+    if (cycles > stats->max_cycles) {
+        stats->max_cycles = cycles;
+    }
+
+    // time since the previous entry shows how long this line was held off
+    if (stats->last_entry != 0 && entry > stats->last_entry) {
+        gap = entry - stats->last_entry;
+        if ((gap >> 32) == 0 && (uint32_t)gap > stats->max_gap_cycles) {
+            stats->max_gap_cycles = (uint32_t)gap;
+        }
+    }
+    stats->last_entry = entry;
+
+    // log2 bucket, last bucket is open ended
+    v = cycles >> (IRQ_HIST_SHIFT + 1);
+    bucket = 0;
+    while (v != 0 && bucket < IRQ_HIST_BUCKETS - 1) {
+        v >>= 1;
+        bucket++;
+    }
+    stats->hist[bucket]++;
+    restore_flags(flags);
+}
+
+/* irq_stats_get
+ * 
+ * copies out a consistent snapshot of the stats for one IRQ
+ * Inputs: irq -- PIC line
+ *         out -- struct to fill
+ * Outputs: 0 on success, -1 on bad input
+ * Side Effects: None
+ */
+int32_t irq_stats_get(uint32_t irq, irq_stats_t* out){
+    uint32_t flags;
+    if (irq >= IRQ_STATS_NUM || out == NULL) return -1;
+
+    cli_and_save(flags);
+    *out = irq_stats[irq];
+    restore_flags(flags);
+    return 0;
+}
+
+/* irq_stats_reset
+ * 
+ * clears the stats for every IRQ
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: zeroes all counters and histograms
+ */
+void irq_stats_reset(void){
+    uint32_t flags;
+    cli_and_save(flags);
+    memset(irq_stats, 0, sizeof(irq_stats));
+    restore_flags(flags);
+}
+
+/* report_printf
+ * 
+ * printf to any byte sink, for the report
+ * Inputs: emit -- where the characters go
+ *         format -- printf style format, followed by its arguments
+ * Outputs: number of format characters consumed
+ * Side Effects: None
+ */
+static int32_t report_printf(void (*emit)(uint8_t), int8_t* format, ...){
+    int32_t* esp = (void *)&format;
+    esp++;
+
+    return vformat(emit, format, esp);
+}
+
+/* irq_stats_report
+ * 
+ * formats count, worst duration, worst gap and histogram for every IRQ that has fired
+ * Inputs: emit -- where the characters go
+ * Outputs: None
+ * Side Effects: None
+ */
+static void irq_stats_report(void (*emit)(uint8_t)){
+    irq_stats_t snap;
+    uint32_t irq, i;
+
+    report_printf(emit, "irq   count      max cyc    max gap cyc  (hist from <2^%u cyc)\n", IRQ_HIST_SHIFT + 1);
+    for (irq = 0; irq < IRQ_STATS_NUM; irq++) {
+        irq_stats_get(irq, &snap);
+        if (snap.count == 0) continue;
+
+        report_printf(emit, "%u: %u %u %u\n   ", irq, snap.count, snap.max_cycles, snap.max_gap_cycles);
+        for (i = 0; i < IRQ_HIST_BUCKETS; i++) {
+            report_printf(emit, " %u", snap.hist[i]);
+        }
+        report_printf(emit, "\n");
+    }
+}
+
+/* irq_stats_dump
+ * 
+ * prints count, worst duration, worst gap and histogram for every IRQ that has fired
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: writes to the screen
+ */
+void irq_stats_dump(void){
+    irq_stats_report(putc);
+}
+
+/* report_putc
+ * 
+ * appends one character to the report the running process is formatting,
+ * drops what does not fit. Keyed by pid so formatting can be preempted
+ * Inputs: c -- character
+ * Outputs: None
+ * Side Effects: None
+ */
+static void report_putc(uint8_t c){
+    irq_report_t* r = report_target[(uint8_t)current_pid];
+
+    if (r->len < IRQ_REPORT_SIZE) {
+        r->text[r->len++] = c;
+    }
+}
+
+/* report_put
+ * 
+ * drops one fd's hold on a report
+ * Inputs: slot -- inode_num of an irqstats fd, report index + 1, 0 for none
+ * Outputs: None
+ * Side Effects: None
+ */
+static void report_put(uint32_t slot){
+    uint32_t flags;
+
+    if (slot == 0 || slot > IRQ_REPORT_SLOTS) return;
+    cli_and_save(flags);
+    if (irq_reports[slot - 1].refs > 0) {
+        irq_reports[slot - 1].refs--;
+    }
+    restore_flags(flags);
+}
+
+/* irq_stats_ref
+ * 
+ * another fd now shares the report of an irqstats fd, for dup2 and fork
+ * Inputs: slot -- inode_num of the fd being copied
+ * Outputs: None
+ * Side Effects: None
+ */
+void irq_stats_ref(uint32_t slot){
+    uint32_t flags;
+
+    if (slot == 0 || slot > IRQ_REPORT_SLOTS) return;
+    cli_and_save(flags);
+    irq_reports[slot - 1].refs++;
+    restore_flags(flags);
+}
+
+/* report_snapshot
+ * 
+ * formats a fresh report for an fd. Reuses the fd's report if nobody shares
+ * it, otherwise takes a free one. Formatting runs with interrupts on
+ * Inputs: fda -- the irqstats fd, its inode_num names its report
+ * Outputs: 0, -1 if every report is in use
+ * Side Effects: None
+ */
+static int32_t report_snapshot(fda_entry_t* fda){
+    uint32_t flags, i;
+    irq_report_t* r = NULL;
+
+    cli_and_save(flags);
+    if (fda->inode_num != 0 && irq_reports[fda->inode_num - 1].refs == 1) {
+        r = &irq_reports[fda->inode_num - 1];
+    } else {
+        for (i = 0; i < IRQ_REPORT_SLOTS; i++) {
+            if (irq_reports[i].refs == 0) {
+                r = &irq_reports[i];
+                r->refs = 1;
+                break;
+            }
+        }
+        if (r != NULL) {
+            report_put(fda->inode_num);
+            fda->inode_num = i + 1;
+        }
+    }
+    restore_flags(flags);
+    if (r == NULL) return -1;
+
+    r->len = 0;
+    report_target[(uint8_t)current_pid] = r;
+    irq_stats_report(report_putc);
+    return 0;
+}
+
+/* irq_stats_open
+ * 
+ * opens the "irqstats" device, a text report of the handler timings
+ * Inputs: filename -- not used
+ * Outputs: 0
+ * Side Effects: None
+ */
+int32_t irq_stats_open(const uint8_t* filename){
+    return 0;
+}
+
+/* irq_stats_close
+ * 
+ * closes the "irqstats" device
+ * Inputs: fd -- irqstats file descriptor of the running process
+ * Outputs: 0
+ * Side Effects: frees its report once no other fd shares it
+ */
+int32_t irq_stats_close(int32_t fd){
+    report_put(pcb_array[(uint8_t)current_pid]->proc->fdarray[fd].inode_num);
+    return 0;
+}
+
+/* irq_stats_read
+ * 
+ * a read at offset 0 takes a snapshot of the report for this fd, later reads
+ * go on through the same snapshot, so a reader in small chunks still gets
+ * one consistent report and then 0
+ * Inputs: fd -- irqstats file descriptor
+ *         buf -- user buffer
+ *         nbytes -- size of buf
+ * Outputs: number of bytes copied, 0 at the end of the report, -1 on bad input
+ *          or if too many irqstats fds are reading at once
+ * Side Effects: advances the fd's file_pos
+ */
+int32_t irq_stats_read(int32_t fd, void* buf, int32_t nbytes){
+    fda_entry_t* curr_file;
+    irq_report_t* r;
+    int32_t n;
+
+    if (buf == NULL || nbytes < 0 || fd < 0 || fd >= 8) return -1;
+    if ((uint32_t)buf < USRMEM_BOTTOM || (uint32_t)nbytes > USRMEM_TOP - (uint32_t)buf) return -1;
+
+    curr_file = &pcb_array[(uint8_t)current_pid]->proc->fdarray[fd];
+    if ((curr_file->file_pos == 0 || curr_file->inode_num == 0) && -1 == report_snapshot(curr_file)) return -1;
+    r = &irq_reports[curr_file->inode_num - 1];
+
+    n = (curr_file->file_pos < r->len) ? r->len - curr_file->file_pos : 0;
+    if (n > nbytes) {
+        n = nbytes;
+    }
+    memcpy(buf, r->text + curr_file->file_pos, n);
+
+    curr_file->file_pos += n;
+    return n;
+}
+
+/* irq_stats_write
+ * 
+ * any write starts the measurement over
+ * Inputs: fd -- not used
+ *         buf -- not used
+ *         nbytes -- returned as is
+ * Outputs: nbytes, or -1 on bad input
+ * Side Effects: zeroes the stats of every IRQ
+ */
+int32_t irq_stats_write(int32_t fd, const void* buf, int32_t nbytes){
+    if (nbytes < 0) return -1;
+    irq_stats_reset();
+    return nbytes;
+}
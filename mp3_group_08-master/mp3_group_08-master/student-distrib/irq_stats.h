@@ -0,0 +1,48 @@
+#ifndef _IRQ_STATS_H
+#define _IRQ_STATS_H
+
+#include "types.h"
+
+#define IRQ_STATS_NUM       16  // one slot per PIC line
+#define IRQ_HIST_BUCKETS    16  // log2 histogram buckets
+#define IRQ_HIST_SHIFT      8   // bucket 0 holds everything under 2^9 cycles
+
+#ifndef ASM
+
+/* per-IRQ handler timing, all durations in TSC cycles */
+typedef struct irq_stats {
+    uint32_t count;                         // completed handler runs
+    uint32_t max_cycles;                    // worst entry -> exit time
+    uint64_t total_cycles;                  // sum of entry -> exit times
+    uint32_t max_gap_cycles;                // worst time between two entries
+    uint64_t last_entry;                    // entry stamp of the previous run
+    uint32_t hist[IRQ_HIST_BUCKETS];        // bucket i counts durations < 2^(i + 1 + IRQ_HIST_SHIFT)
+} irq_stats_t;
+
+/* entry stamps written by the CREATE_HANDLER linkage in assembly_linkage.S */
+extern uint64_t irq_entry_tsc[IRQ_STATS_NUM];
+
+/* called by the linkage after the C handler returns */
+void irq_stats_record(uint32_t irq, uint64_t exit_tsc);
+
+/* copies out the stats for one IRQ, returns -1 on a bad irq */
+int32_t irq_stats_get(uint32_t irq, irq_stats_t* out);
+
+/* zeroes the stats for every IRQ */
+void irq_stats_reset(void);
+
+/* prints count, max and histogram for every IRQ that has fired */
+void irq_stats_dump(void);
+
+/* another fd shares the report of an irqstats fd, slot is that fd's inode_num */
+void irq_stats_ref(uint32_t slot);
+
+/* file operations for the "irqstats" device: each fd reads its own snapshot of the report, a write resets */
+int32_t irq_stats_open(const uint8_t* filename);
+int32_t irq_stats_close(int32_t fd);
+int32_t irq_stats_read(int32_t fd, void* buf, int32_t nbytes);
+int32_t irq_stats_write(int32_t fd, const void* buf, int32_t nbytes);
+
+#endif /* ASM */
+
+#endif /* _IRQ_STATS_H */
@@ -3,12 +3,14 @@
 #include "i8259.h"
 #include "terminal.h"
 #include "paging.h"
+#include "scrollback.h"
+#include "input.h"
+#include "irq_stats.h"
 
 /* Holds a mapping from a scan code to a character being typed. */
 //39 == ascii code for '
 //
 
-#define MAX_BUF_SIZE            128
 
 unsigned char lowercase_code_table[0x3A] = {0, 0, '1', '2', '3', '4', '5', '6', '7', '8', '9', '0', '-', '=', 
                                             0, 0, 'q', 'w', 'e', 'r', 't', 'y', 'u', 'i', 'o', 'p', '[', ']', 10, 17, 
@@ -30,6 +32,8 @@ unsigned char CAPSSHIFT_code_table[0x3A] = {0, 0, '!', '@', '#', '$', '%', '^',
                                             'a', 's', 'd', 'f', 'g', 'h', 'j', 'k', 'l', ':', '"', '~', 15, '|', 'z', 
                                             'x', 'c', 'v', 'b', 'n', 'm', '<', '>', '?', 0, 0, 0, 32};
 
+static kbd_ring_t kbd_ring[3]; // 3 terminals
+
 /*
  * keyboard_init
  *   DESCRIPTION: Enables keyboard interrupts
@@ -47,14 +51,18 @@ void keyboard_init(void) {
 
 /*
  * keyboard_handler
- *   DESCRIPTION: Handles keyboard data upon a called interrupt.
+ *   DESCRIPTION: Handles keyboard data upon a called interrupt. Modifiers,
+ *                terminal switching and scrollback are handled here, every
+ *                other key press is queued for the terminal on screen and
+ *                edited/echoed later by whoever reads that terminal
  *   INPUTS: none
- *   OUTPUTS: the character typed to the terminal
+ *   OUTPUTS: none
  *   RETURN VALUE: none
- *   SIDE EFFECTS: none
+ *   SIDE EFFECTS: one port read and at most one ring push for a normal key
  */   
 void keyboard_handler(void) {
     uint32_t code;
+    uint16_t key;
     //mask interrupts
     cli();
 
@@ -66,246 +74,170 @@ void keyboard_handler(void) {
         sti();
         return;
     }
-        
 
         // read keyboard scan code
     code = inb(KEYBOARD_DATA);
 
+    //programs with the keyboard device open see every press and release
+    input_report_key(cur_terminal, code, irq_entry_tsc[1]);
 
-    /* SPECIAL CHARACTERS
-    * backspace (0x0E) - will have to delete last char 
-    * tab (0x0F) - will have to print space four times
-    * LCTRL (0x1D) - clear screen
-    * LSHIFT (0X2A) - set shift bool = true
-    * RSHIFT (0x36) - set shift bool = true
-    * CAPSLOCK (0x3A) - set capslock bool = true
-    * NOTHING CHARACTERS
-    * ESCAPE (0x01)
-    * 0x3B - 0x80
-    * IMPORTANT RELEASE CODES 
-    * LSHIFT (0xAB) - set shift bool = false
-    * RSHIFT (0xB6) - set shift bool = false
-    * CAPSLOCK (0xBB) - set capslock bool = false
+    /* MODIFIERS
+    * LSHIFT (0X2A/0xAA), RSHIFT (0x36/0xB6) - shift bool
+    * CAPSLOCK (0x3A) - toggles capslock bool
+    * LCTRL (0x1D/0x9D) - control bool
+    * LALT (0x38/0xB8) - alt bool
+    * every other release code is ignored
     */
+    switch(code){
+        case 0x2A: //LSHIFT PRESS
+        case 0x36: //RSHIFT PRESS
+            SHFT_PRESS = 1;
+            break;
+        case 0xAA: //LSHIFT RELEASE
+        case 0xB6: //RSHIFT RELEASE
+            SHFT_PRESS = 0;
+            break;
+        case 0x3A: //CAPSLOCK PRESS
+            CPSLOCK_PRESS = !CPSLOCK_PRESS;
+            break;
+        case 0x1D: //LCONTROL PRESS
+            LCTRL_PRESS = 1;
+            break;
+        case 0x9D: //LCONTROL RELEASE
+            LCTRL_PRESS = 0;
+            break;
+        case 0x38: //LALT PRESS
+            ALT_PRESS = 1;
+            break;
+        case 0xB8: //LALT RELEASE
+            ALT_PRESS = 0;
+            break;
+    }
+    if((code & 0x80) || code == 0x2A || code == 0x36 || code == 0x3A || code == 0x1D || code == 0x38){
+        sti();
+        return;
+    }
 
-    //local copy of keyboard index
-    uint32_t keyboard_index;
-    int i;
-    // local copy of keyboard buffer
-    char keyboard_buffer[128];
-    int curr_screen_x = get_cursor_x();
-    int curr_screen_y = get_cursor_y();
-
-    terminal_t* active_term = &(terminal_struct[cur_terminal]);
-
-    if(active_term->enter_flag){ //if enter was just pushed, clear keyboard buffer, index and reset flag
-        keyboard_index = 0;
-        memset(keyboard_buffer, 0, 128);
-        active_term->enter_flag = 0;
-    } else{ //otherwise, set local copy to current buffer and index
-        for(i=0; i < 128; i++){
-            keyboard_buffer[i] = active_term->keyboard_buf[i];
+    // switching and scrollback touch the screen of a terminal that may not be scheduled,
+    // the kernel's text memory mapping never follows the scheduled process so that is fine
+    if(SHFT_PRESS && (code == 0x49 || code == 0x51)){ //Shift+PgUp/PgDn
+        scrollback_scroll(cur_terminal, (code == 0x49) ? SCROLLBACK_PAGE : -SCROLLBACK_PAGE);
+    } else{
+        //any other key press drops out of the scrollback view
+        scrollback_reset(cur_terminal);
+
+        if((code == 0x3B || code == 0x3C || code == 0x3D) && ALT_PRESS){ //code is either F1, F2, or F3
+            switch_terminal(code);
+        } else if(typing_mask[cur_terminal]){ //paint mode takes no keys
+            key = code;
+            if(SHFT_PRESS){
+                key |= KEY_SHIFT;
+            }
+            if(CPSLOCK_PRESS){
+                key |= KEY_CAPS;
+            }
+            if(LCTRL_PRESS){
+                key |= KEY_CTRL;
+            }
+            kbd_ring_push(cur_terminal, key);
         }
-        keyboard_index = active_term->keyboard_idx;
     }
 
+    //unmask interrupts
+    sti();
+}
 
-    uint32_t paging_status = vidmap_page_table[VIDMEM_INDEX].physical_address;
-    vidmap_page_table[VIDMEM_INDEX].physical_address = VIDMEM_INDEX;
-
-        switch(code){
-            case 0x0E: //backspace
-                if((keyboard_index > 0) & ((curr_screen_x > 0) | (curr_screen_y > 0))){ //do not delete if no chars in buffer or at beginning of screen
-                    if(curr_screen_x == 0){ //if at beginning of line
-                        curr_screen_x = 79; //go back to end of previous line
-                        curr_screen_y--;
-                    } else{
-                        curr_screen_x--; //otherwise go back one space on same line
-                    }
-                    update_term_struct(curr_screen_x, curr_screen_y);
-                    putc(32); //replace char with space
-                    keyboard_index--; //decrement index
-                    active_term->keyboard_buf[keyboard_index] = 0; //clear char in keyboard buffer
-                    active_term->keyboard_idx = keyboard_index;
-                    memcpy(active_term->command_buf[0], &(keyboard_buffer), MAX_BUF_SIZE);
-                    active_term->command_idx[0] = keyboard_index;
-                    set_cursor(curr_screen_x, curr_screen_y); //set cursor
-                }
-                break;
-            case 0x0F: //TAB
-                putc(32); //putc four spaces
-                putc(32);
-                putc(32);
-                putc(32);
-                break;
-            case 0x2A: //LSHIFT PRESS
-                if(SHFT_PRESS == 0){
-                    SHFT_PRESS = 1;
-                }
-                break;
-            case 0x36: //RSHIFT PRESS
-                if(SHFT_PRESS == 0){
-                    SHFT_PRESS = 1;
-                }
-                break;
-            case 0x3A: //CAPSLOCK PRESS
-                if(CPSLOCK_PRESS == 0){
-                    CPSLOCK_PRESS = 1;
-                } else{
-                    CPSLOCK_PRESS = 0;
-                }
-                break;
-            case 0xAA: //LSHIFT RELEASE
-                if(SHFT_PRESS == 1){
-                    SHFT_PRESS = 0;
-                }
-                break;
-            case 0xB6: //RSHIFT RELEASE
-                if(SHFT_PRESS == 1){
-                    SHFT_PRESS = 0;
-                }
-                break;
-            case 0x1D: //LCONTROL PRESS
-                if(LCTRL_PRESS == 0){
-                    LCTRL_PRESS = 1;
-                }
-                break;
-            case 0x9D: //LCONTROL RELEASE
-                if(LCTRL_PRESS == 1){
-                    LCTRL_PRESS = 0;
-                }
-                break;
-            case 0x37: //NUMPAD *
-                break;
-            case 0x38: //LALT PRESS
-                if(ALT_PRESS == 0){
-                    ALT_PRESS = 1;
-                }
-                break;
-            case 0xB8: //LALT RELEASE
-                if(ALT_PRESS == 1){
-                    ALT_PRESS = 0;
-                }
-                break;
-            case 0x1C: //ENTER
-                if(!typing_mask[cur_terminal]){
-                    break;
-                }
-                if(curr_screen_y == 24){ //if at bottom of screen, shift
-                    shift_screen();
-                } else{
-                    putc(10);
-                }
-                active_term->enter_flag = 1;
-                break;
-            case 0x48: //UP ARROW
-                if(!typing_mask[cur_terminal]){
-                    break;
-                }
-                if(active_term->command_pos >= 9){ //checks to make sure we're not at last 
-                    active_term->command_pos = 9;
-                    break;
-                } else if(active_term->command_idx[++active_term->command_pos] == 0){ //check if we're at end of queue
-                    active_term->command_pos--;
-                    break;
-                }
-                int prev_command_pos = active_term->command_pos-1;
-                if(active_term->command_pos == 1){
-                    memcpy(&(active_term->command_buf[0]), active_term->keyboard_buf, MAX_BUF_SIZE);
-                    active_term->command_idx[0] = active_term->keyboard_idx;
-                } 
-
-                set_cursor(curr_screen_x - active_term->command_idx[prev_command_pos], curr_screen_y);
-                for(i=0; i< active_term->command_idx[prev_command_pos]; i++){
-                    putc(32);    
-                }
-                set_cursor(curr_screen_x - active_term->keyboard_idx, curr_screen_y);
- 
-                puts(active_term->command_buf[active_term->command_pos]);
-
-                //copies current command into keyboard_buf & idx
-                memcpy(&(active_term->keyboard_buf), active_term->command_buf[active_term->command_pos], MAX_BUF_SIZE);
-                active_term->keyboard_idx = active_term->command_idx[active_term->command_pos];
-
-                vidmap_page_table[VIDMEM_INDEX].physical_address = paging_status;
-                sti();
-                return;
-            case 0x50: //DOWN ARROW
-                if(!typing_mask[cur_terminal]){
-                    break;
-                }
-                if(active_term->command_pos <= 0){
-                    active_term->command_pos = 0;
-                    break;
-                }
-                int last_command_pos = active_term->command_pos;
-                active_term->command_pos--;
-
-
-                set_cursor(curr_screen_x - active_term->command_idx[last_command_pos], curr_screen_y);
-                for(i=0; i< active_term->command_idx[last_command_pos]; i++){
-                    putc(32);    
-                }
-                set_cursor(curr_screen_x - active_term->keyboard_idx, curr_screen_y);
+/* kbd_ring_push
+ * 
+ * adds a keystroke for a terminal, only ever called with interrupts off
+ * Inputs: terminal, keystroke
+ * Outputs: 0 on success, -1 if the ring is full and the key was dropped
+ * Side Effects: None
+ */
+int32_t kbd_ring_push(uint8_t term, uint16_t key){
+    kbd_ring_t* ring = &kbd_ring[term];
+    if(ring->head - ring->tail == KBD_RING_SIZE){
+        ring->dropped++;
+        return -1;
+    }
+    ring->keys[ring->head & (KBD_RING_SIZE - 1)] = key;
+    asm volatile("" ::: "memory"); //key must be in place before head moves
+    ring->head++;
+    wake_up(&ring->readers);
+    return 0;
+}
 
-                puts(active_term->command_buf[active_term->command_pos]);
+/* kbd_ring_pop
+ * 
+ * takes the oldest keystroke for a terminal, safe with interrupts on
+ * Inputs: terminal, where to put the keystroke
+ * Outputs: 0 on success, -1 if nothing is waiting
+ * Side Effects: None
+ */
+int32_t kbd_ring_pop(uint8_t term, uint16_t* key){
+    kbd_ring_t* ring = &kbd_ring[term];
+    if(ring->tail == ring->head){
+        return -1;
+    }
+    *key = ring->keys[ring->tail & (KBD_RING_SIZE - 1)];
+    asm volatile("" ::: "memory"); //read the key before giving the slot back
+    ring->tail++;
+    return 0;
+}
 
-                memcpy(&(active_term->keyboard_buf), active_term->command_buf[active_term->command_pos], MAX_BUF_SIZE);
-                active_term->keyboard_idx = active_term->command_idx[active_term->command_pos];
+/* kbd_ring_pending
+ * 
+ * Inputs: terminal
+ * Outputs: number of keystrokes waiting
+ * Side Effects: None
+ */
+uint32_t kbd_ring_pending(uint8_t term){
+    return kbd_ring[term].head - kbd_ring[term].tail;
+}
 
-                vidmap_page_table[VIDMEM_INDEX].physical_address = paging_status;
-                sti();
-                return;
-            case 0x26: //L, MUST BE LAST CASE BEFORE DEFAULT
-                if(LCTRL_PRESS){
-                    clear_screen();
-                    break;
-                }
-            default:
-                write_keyboard_char(code, &keyboard_index, keyboard_buffer);
-        }
+/* kbd_ring_wait_queue
+ * 
+ * Inputs: terminal
+ * Outputs: the queue readers of that terminal sleep on
+ * Side Effects: None
+ */
+wait_queue_t* kbd_ring_wait_queue(uint8_t term){
+    return &kbd_ring[term].readers;
+}
 
-    //unmask interrupts
-    vidmap_page_table[VIDMEM_INDEX].physical_address = paging_status;
-    sti();
+/* kbd_ring_flush
+ * 
+ * drops everything waiting, consumer side only
+ * Inputs: terminal
+ * Outputs: None
+ * Side Effects: None
+ */
+void kbd_ring_flush(uint8_t term){
+    kbd_ring[term].tail = kbd_ring[term].head;
 }
 
-/* write keyboard_char
+/* key_char
  * 
- * writes inputted keyboard code to screen and keyboard buffer
- * Inputs: PS2 code, keyboard index, keyboard buffer
- * Outputs: int 1 on write, 0 on no write
+ * looks up the character a keystroke makes under the shift and capslock
+ * state it was pressed with
+ * Inputs: keystroke
+ * Outputs: the printable character, 0 for keys that do not make one
  * Side Effects: None
  */
-uint8_t write_keyboard_char(int32_t code, uint32_t* keyboard_index, char keyboard_buffer[128]){
-    if((code == 0x3B || code == 0x3C || code == 0x3D) && ALT_PRESS){ //code is either F1, F2, or F3
-        switch_terminal(code);
-        return 0; //returns 0 to indicated no char was written
+char key_char(uint16_t key){
+    uint8_t code = KEY_CODE(key);
+    char c;
+    if(code >= 0x3A){
+        return 0;
     }
-    if(code < 0x3A && *keyboard_index < 72 && typing_mask[cur_terminal]){ //only write when code is valid and less than 128 characters have been written
-        //logic to decide where to source character to print from 
-        terminal_t* active_term = &(terminal_struct[cur_terminal]);
-        int i;
-        if(SHFT_PRESS & CPSLOCK_PRESS){
-            putc(CAPSSHIFT_code_table[code]);
-            keyboard_buffer[*keyboard_index] = CAPSSHIFT_code_table[code];
-        } else if(SHFT_PRESS){
-            putc(SHIFT_code_table[code]);
-                keyboard_buffer[*keyboard_index] = SHIFT_code_table[code];
-        } else if(CPSLOCK_PRESS){
-            putc(CAPSLOCK_code_table[code]);
-                keyboard_buffer[*keyboard_index] = CAPSLOCK_code_table[code];
-        } else{
-            putc(lowercase_code_table[code]);
-                keyboard_buffer[*keyboard_index] = lowercase_code_table[code];
-        }
-        (*keyboard_index)++;
-        active_term->keyboard_idx = *keyboard_index;
-        //write local buffer back to screen struct (all 128 characters)
-        for(i = 0; i < 128; i++){
-            active_term->keyboard_buf[i] = keyboard_buffer[i];
-        }
-        return 1; //returns 1 to indicate character was written
+    if((key & KEY_SHIFT) && (key & KEY_CAPS)){
+        c = CAPSSHIFT_code_table[code];
+    } else if(key & KEY_SHIFT){
+        c = SHIFT_code_table[code];
+    } else if(key & KEY_CAPS){
+        c = CAPSLOCK_code_table[code];
+    } else{
+        c = lowercase_code_table[code];
     }
-    return 0; //returns 0 to indicate no char was written
+    return (c >= ' ') ? c : 0;
 }
@@ -2,11 +2,21 @@
 #define _KEYBOARD_H
 
 #include "types.h"
+#include "wait_queue.h"
 
 #define KEYBOARD_DATA       0x60
 #define KEYBOARD_STATUS     0x64
 #define LAST_BIT            0x01
 
+#define KBD_RING_SIZE       64      // keystrokes buffered per terminal, must be a power of 2
+
+/* a keystroke is the press scan code in the low byte and the modifiers that
+ * were held when it was pressed above it */
+#define KEY_CODE(key)       ((key) & 0xFF)
+#define KEY_SHIFT           0x100
+#define KEY_CAPS            0x200
+#define KEY_CTRL            0x400
+
 uint8_t SHFT_PRESS;
 uint8_t CPSLOCK_PRESS;
 uint8_t LCTRL_PRESS;
@@ -15,14 +25,40 @@ uint8_t ALT_PRESS;
 extern uint8_t write_term_idx;
 extern uint8_t typing_mask[3];
 
+/* keystrokes waiting for one terminal. The keyboard interrupt is the only
+ * producer and only moves head, the reading process is the only consumer
+ * and only moves tail, so neither side needs a lock */
+typedef struct kbd_ring_t {
+    uint16_t keys[KBD_RING_SIZE];
+    volatile uint32_t head;     // total keystrokes ever pushed
+    volatile uint32_t tail;     // total keystrokes ever popped
+    uint32_t dropped;           // keystrokes lost to a full ring
+    wait_queue_t readers;       // woken by every push
+} kbd_ring_t;
+
 /* enables irq for a keyboard */
 void keyboard_init();
 
-/* handles a keyboard interrupt and prints key */
+/* handles a keyboard interrupt and queues the key for the terminal on screen */
 void keyboard_handler();
 
-/* writes a single character specified by code to screen*/
-uint8_t write_keyboard_char(int32_t code, uint32_t* keyboard_index, char keyboard_buffer[128]);
+/* producer side, adds a keystroke to term's ring, returns -1 when full */
+int32_t kbd_ring_push(uint8_t term, uint16_t key);
+
+/* consumer side, takes the oldest keystroke, returns -1 when empty */
+int32_t kbd_ring_pop(uint8_t term, uint16_t* key);
+
+/* nonzero if term has keystrokes waiting */
+uint32_t kbd_ring_pending(uint8_t term);
+
+/* what a reader of term sleeps on until a key comes in */
+wait_queue_t* kbd_ring_wait_queue(uint8_t term);
+
+/* drops every keystroke waiting for term */
+void kbd_ring_flush(uint8_t term);
+
+/* character a keystroke makes, 0 if it makes none */
+char key_char(uint16_t key);
 
 /* shifts screen up by one row, leaving an empty row at the bottom*/
 void shift_screen();
@@ -0,0 +1,303 @@
+#include "klog.h"
+#include "lib.h"
+#include "serial.h"
+#include "paging.h"
+#include "file_system.h"
+
+#define KLOG_MASK (KLOG_SIZE - 1)
+
+static int8_t klog_ring[KLOG_SIZE];
+static uint32_t klog_head;                      // total bytes ever appended
+static uint32_t sink_pos[KLOG_NUM_SINKS];       // how far each sink has drained
+static uint32_t klog_sinks = KLOG_SINK_SERIAL | KLOG_SINK_E9;
+static volatile uint8_t klog_pending;           // set by the tick when a sink is behind
+
+extern uint8_t write_term_idx;
+
+/* klog_putc
+ * 
+ * appends a single byte, the oldest byte is overwritten once the ring is full.
+ * Callers hold interrupts off.
+ * Inputs: c -- byte to append
+ * Outputs: None
+ * Side Effects: advances klog_head
+ */
+static void klog_putc(uint8_t c){
+    klog_ring[klog_head & KLOG_MASK] = c;
+    klog_head++;
+}
+
+/* klog_printf
+ * 
+ * formats a message straight into the ring, costs the same no matter which sinks are on
+ * Inputs: format -- printf style format, followed by its arguments
+ * Outputs: number of format characters consumed
+ * Side Effects: None
+ */
+int32_t klog_printf(int8_t* format, ...){
+    uint32_t flags;
+    int32_t ret;
+    int32_t* esp = (void *)&format;
+    esp++;
+
+    cli_and_save(flags);
+    ret = vformat(klog_putc, format, esp);
+    restore_flags(flags);
+    return ret;
+}
+
+/* klog_write
+ * 
+ * appends n raw bytes to the ring
+ * Inputs: s -- bytes to append
+ *         n -- number of bytes
+ * Outputs: n, or -1 on a NULL buffer
+ * Side Effects: None
+ */
+int32_t klog_write(const int8_t* s, uint32_t n){
+    uint32_t i, flags;
+    if (s == NULL) return -1;
+
+    cli_and_save(flags);
+    for (i = 0; i < n; i++) {
+        klog_putc(s[i]);
+    }
+    restore_flags(flags);
+    return n;
+}
+
+/* klog_set_sinks
+ * 
+ * chooses where klog_flush copies the log. A newly enabled sink starts at the
+ * current end of the log instead of replaying everything.
+ * Inputs: mask -- KLOG_SINK_* bits
+ * Outputs: None
+ * Side Effects: None
+ */
+void klog_set_sinks(uint32_t mask){
+    uint32_t i, flags;
+    cli_and_save(flags);
+    for (i = 0; i < KLOG_NUM_SINKS; i++) {
+        if ((mask & (1 << i)) && !(klog_sinks & (1 << i))) {
+            sink_pos[i] = klog_head;
+        }
+    }
+    klog_sinks = mask;
+    restore_flags(flags);
+}
+
+/* sink_emit
+ * 
+ * hands one byte to a sink
+ * Inputs: sink -- sink index (bit number of KLOG_SINK_*)
+ *         c -- byte to write
+ * Outputs: 0 if taken, -1 if the sink is full and the byte should be retried later
+ * Side Effects: device output
+ */
+static int32_t sink_emit(uint32_t sink, uint8_t c){
+    switch (1 << sink) {
+        case KLOG_SINK_VGA:
+            putc(c);
+            return 0;
+        case KLOG_SINK_SERIAL:
+            return serial_putc(c);
+        case KLOG_SINK_E9:
+            outb(c, KLOG_E9_PORT);
+            return 0;
+    }
+    return 0;
+}
+
+/* flush_sinks
+ * 
+ * copies new bytes to each enabled sink, at most budget bytes per sink.
+ * A sink that fell more than a ring behind skips the lost part. Each byte
+ * is one step with interrupts off, so the caller may run with them on and
+ * two callers that interleave only share the work.
+ * Inputs: budget -- most bytes any one sink gets
+ * Outputs: None
+ * Side Effects: device output, may print to the displayed terminal
+ */
+static void flush_sinks(uint32_t budget){
+    uint32_t i, n, flags;
+    int32_t sent;
+    uint8_t saved_term;
+
+    for (i = 0; i < KLOG_NUM_SINKS; i++) {
+        for (n = 0; n < budget; n++) {
+            cli_and_save(flags);
+            if (!(klog_sinks & (1 << i)) || sink_pos[i] == klog_head) {
+                restore_flags(flags);
+                break;
+            }
+            if (klog_head - sink_pos[i] > KLOG_SIZE) {
+                sink_pos[i] = klog_head - KLOG_SIZE;
+            }
+
+            // the vga sink writes to the displayed terminal no matter who is running
+            saved_term = write_term_idx;
+            if ((1 << i) == KLOG_SINK_VGA) {
+                write_term_idx = 0;
+            }
+            sent = sink_emit(i, klog_ring[sink_pos[i] & KLOG_MASK]);
+            write_term_idx = saved_term;
+            if (sent != -1) {
+                sink_pos[i]++;
+            }
+            restore_flags(flags);
+
+            if (sent == -1) break;
+        }
+    }
+}
+
+/* klog_tick
+ * 
+ * the pit's share of the log: only notes that some sink is behind, the
+ * draining is left to klog_flush when the cpu is idle
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: call with interrupts off
+ */
+void klog_tick(void){
+    uint32_t i;
+
+    for (i = 0; i < KLOG_NUM_SINKS; i++) {
+        if ((klog_sinks & (1 << i)) && sink_pos[i] != klog_head) {
+            klog_pending = 1;
+            return;
+        }
+    }
+}
+
+/* klog_flush
+ * 
+ * deferred half of the log, run from the idle loop of a sleeping process.
+ * Drains at most KLOG_FLUSH_BUDGET bytes per sink per tick, with interrupts
+ * on, so a burst of logging is spread over several ticks and never delays an irq.
+ * Inputs: None
+ * Outputs: 1 if it drained (and had interrupts on for a while), 0 if there was nothing to do
+ * Side Effects: call with interrupts off, returns with them off. Device output,
+ *               may print to the displayed terminal
+ */
+int32_t klog_flush(void){
+    if (!klog_pending) return 0;
+
+    klog_pending = 0;
+    sti();
+    flush_sinks(KLOG_FLUSH_BUDGET);
+    cli();
+    return 1;
+}
+
+/* klog_panic
+ * 
+ * logs a fatal message. The caller is about to stop the kernel, so nothing will
+ * flush the log later: every sink is drained right here (serial by polling) and
+ * the message is drawn on screen even when the vga sink is off.
+ * Inputs: format -- printf style format, followed by its arguments
+ * Outputs: number of format characters consumed
+ * Side Effects: device output, prints to the displayed terminal
+ */
+int32_t klog_panic(int8_t* format, ...){
+    uint32_t flags, start, i;
+    uint8_t saved_term;
+    int32_t ret;
+    int32_t* esp = (void *)&format;
+    esp++;
+
+    cli_and_save(flags);
+    start = klog_head;
+    ret = vformat(klog_putc, format, esp);
+
+    // the serial sink stops whenever its tx ring fills, so alternate with a polled drain
+    for (i = 0; i <= KLOG_SIZE / SERIAL_TX_SIZE; i++) {
+        flush_sinks(KLOG_SIZE);
+        serial_drain_polled();
+    }
+
+    if (!(klog_sinks & KLOG_SINK_VGA)) {
+        saved_term = write_term_idx;
+        write_term_idx = 0;
+        for (i = start; i != klog_head; i++) {
+            putc(klog_ring[i & KLOG_MASK]);
+        }
+        write_term_idx = saved_term;
+    }
+    restore_flags(flags);
+    return ret;
+}
+
+// KMSG DEVICE
+
+/* kmsg_open
+ * 
+ * opens the kernel log for reading, the fd starts at the oldest byte still in the ring
+ * Inputs: filename -- not used
+ * Outputs: 0
+ * Side Effects: None
+ */
+int32_t kmsg_open(const uint8_t* filename){
+    return 0;
+}
+
+/* kmsg_close
+ * 
+ * closes the kernel log
+ * Inputs: fd -- not used
+ * Outputs: 0
+ * Side Effects: None
+ */
+int32_t kmsg_close(int32_t fd){
+    return 0;
+}
+
+/* kmsg_read
+ * 
+ * copies log bytes the fd has not seen yet. file_pos holds an absolute log offset,
+ * so a reader that fell behind silently skips what was overwritten.
+ * Inputs: fd -- kmsg file descriptor
+ *         buf -- user buffer
+ *         nbytes -- size of buf
+ * Outputs: number of bytes copied, 0 once caught up, -1 on bad input
+ * Side Effects: advances the fd's file_pos
+ */
+int32_t kmsg_read(int32_t fd, void* buf, int32_t nbytes){
+    uint32_t pos, oldest, flags;
+    int32_t i;
+    fda_entry_t* curr_file;
+
+    if (buf == NULL || nbytes < 0 || fd < 0 || fd >= 8) return -1;
+    if ((uint32_t)buf < USRMEM_BOTTOM || (uint32_t)nbytes > USRMEM_TOP - (uint32_t)buf) return -1;
+
+    curr_file = &pcb_array[(uint8_t)current_pid]->proc->fdarray[fd];
+
+    cli_and_save(flags);
+    oldest = (klog_head > KLOG_SIZE) ? klog_head - KLOG_SIZE : 0;
+    pos = curr_file->file_pos;
+    if (pos < oldest) {
+        pos = oldest;
+    }
+    for (i = 0; i < nbytes && pos != klog_head; i++, pos++) {
+        ((int8_t*)buf)[i] = klog_ring[pos & KLOG_MASK];
+    }
+    restore_flags(flags);
+
+    curr_file->file_pos = pos;
+    return i;
+}
+
+/* kmsg_write
+ * 
+ * lets user programs add their own lines to the kernel log
+ * Inputs: fd -- not used
+ *         buf -- bytes to log
+ *         nbytes -- number of bytes
+ * Outputs: nbytes, or -1 on bad input
+ * Side Effects: None
+ */
+int32_t kmsg_write(int32_t fd, const void* buf, int32_t nbytes){
+    if (nbytes < 0) return -1;
+    if ((uint32_t)buf < USRMEM_BOTTOM || (uint32_t)nbytes > USRMEM_TOP - (uint32_t)buf) return -1;
+    return klog_write((const int8_t*)buf, nbytes);
+}
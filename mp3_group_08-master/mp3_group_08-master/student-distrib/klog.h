@@ -0,0 +1,40 @@
+#ifndef _KLOG_H
+#define _KLOG_H
+
+#include "types.h"
+
+#define KLOG_SIZE           16384   // ring size in bytes, must be a power of 2
+#define KLOG_FLUSH_BUDGET   512     // most bytes one sink gets per tick
+
+#define KLOG_SINK_VGA       0x1     // the terminal currently on screen
+#define KLOG_SINK_SERIAL    0x2     // COM1
+#define KLOG_SINK_E9        0x4     // qemu/bochs debugcon port
+#define KLOG_NUM_SINKS      3
+#define KLOG_E9_PORT        0xE9
+
+/* appends a formatted message to the log, never touches a device */
+int32_t klog_printf(int8_t* format, ...);
+
+/* logs a fatal message and pushes it to every sink and the screen right away */
+int32_t klog_panic(int8_t* format, ...);
+
+/* appends n raw bytes to the log */
+int32_t klog_write(const int8_t* s, uint32_t n);
+
+/* picks which sinks the flusher drains to (KLOG_SINK_* mask) */
+void klog_set_sinks(uint32_t mask);
+
+/* notes that a sink is behind, all the pit tick does for the log */
+void klog_tick(void);
+
+/* drains up to KLOG_FLUSH_BUDGET bytes to each enabled sink with interrupts on,
+ * called from the idle loop with them off, returns 1 if it drained */
+int32_t klog_flush(void);
+
+/* file operations for the "kmsg" device */
+int32_t kmsg_open(const uint8_t* filename);
+int32_t kmsg_close(int32_t fd);
+int32_t kmsg_read(int32_t fd, void* buf, int32_t nbytes);
+int32_t kmsg_write(int32_t fd, const void* buf, int32_t nbytes);
+
+#endif /* _KLOG_H */
@@ -3,12 +3,94 @@
 
 #include "lib.h"
 #include "terminal.h"
+#include "scrollback.h"
 
 uint8_t write_term_idx = 0;
 
 //static char* video_mem = (char *)VIDEO;
 static uint8_t attrib_Array[3] = {ATTRIB1, ATTRIB2, ATTRIB3};
-uint32_t vmem_Array[4] = {VIDEO, VMEM_TERM1, VMEM_TERM2, VMEM_TERM3};
+uint32_t vmem_Array[3] = {VMEM_TERM1, VMEM_TERM2, VMEM_TERM3};
+
+/* row of each terminal's text memory that is at the top of its screen */
+static uint32_t screen_top[3] = {0, 0, 0};
+/* terminals whose program has vidmapped the screen, these expect the screen
+ * to start at the beginning of their text memory so they keep the old
+ * software scroll */
+uint8_t vidmap_mask[3] = {0, 0, 0};
+
+/* uint8_t target_term(void)
+ * Inputs: void
+ * Return Value: terminal selected by write_term_idx, 0 means the displayed one */
+static uint8_t target_term(void) {
+    return (write_term_idx == 0) ? cur_terminal : (write_term_idx - 1);
+}
+
+/* void crtc_set_start(const uint16_t* cell)
+ * Inputs: cell = text memory cell to show in the top left corner
+ * Return Value: none
+ * Function: programs the CRTC start address (0x0C high, 0x0D low), the start
+ * address counts cells from VIDEO */
+void crtc_set_start(const uint16_t* cell) {
+    uint16_t start = cell - (uint16_t*)VIDEO;
+    outb(0x0C, 0x3D4);
+    outb((uint8_t)(start >> 8), 0x3D5);
+    outb(0x0D, 0x3D4);
+    outb((uint8_t)start, 0x3D5);
+}
+
+/* void console_show(uint8_t term)
+ * Inputs: term = terminal to display
+ * Return Value: none
+ * Function: points the CRTC at the top row of term's screen */
+void console_show(uint8_t term) {
+    crtc_set_start(term_visible(term));
+}
+
+/* void set_screen_top(uint8_t term, uint32_t row)
+ * Inputs: term = terminal, row = row of its text memory to put at the top
+ * Return Value: none
+ * Function: scrolls term in hardware, only touches the CRTC if it is shown */
+static void set_screen_top(uint8_t term, uint32_t row) {
+    screen_top[term] = row;
+    if (term == cur_terminal && !scrollback_viewing(term)) {
+        console_show(term);
+    }
+}
+
+/* char* target_mem(void)
+ * Inputs: void
+ * Return Value: address of the top left cell of the terminal selected by
+ * write_term_idx */
+static char* target_mem(void) {
+    return (char*)term_visible(target_term());
+}
+
+/* uint16_t* term_visible(uint8_t term)
+ * Inputs: term = terminal
+ * Return Value: address of the top left cell of term's screen */
+uint16_t* term_visible(uint8_t term) {
+    return (uint16_t*)vmem_Array[term] + screen_top[term] * NUM_COLS;
+}
+
+/* uint16_t* console_visible(void)
+ * Inputs: void
+ * Return Value: address of the top left cell currently on screen */
+uint16_t* console_visible(void) {
+    return term_visible(cur_terminal);
+}
+
+/* void console_rewrap(uint8_t term)
+ * Inputs: term = terminal
+ * Return Value: none
+ * Function: moves term's screen back to the start of its text memory, so it
+ * begins at vmem_Array[term] again */
+void console_rewrap(uint8_t term) {
+    if (screen_top[term] == 0) {
+        return;
+    }
+    memmove((void*)vmem_Array[term], term_visible(term), NUM_ROWS * NUM_COLS * 2); //2 bytes per cell
+    set_screen_top(term, 0);
+}
 
 /* void clear(void);
  * Inputs: void
@@ -17,7 +99,8 @@ uint32_t vmem_Array[4] = {VIDEO, VMEM_TERM1, VMEM_TERM2, VMEM_TERM3};
 void clear(void) {
     int32_t i;
     //cli();
-    char* video_mem = (char*)vmem_Array[write_term_idx];
+    set_screen_top(target_term(), 0);
+    char* video_mem = target_mem();
     uint8_t attrib_idx = (write_term_idx == 0) ? cur_terminal : (write_term_idx);
     if(write_term_idx != 0){
         attrib_idx--;
@@ -31,6 +114,30 @@ void clear(void) {
 }
 
 /* Standard printf().
+ * Formats to the console with putc, see vformat for the supported
+ * format strings. */
+int32_t printf(int8_t *format, ...) {
+    /* Stack pointer for the other parameters */
+    int32_t* esp = (void *)&format;
+    esp++;
+
+    return vformat(putc, format, esp);
+}
+
+/* static void emit_str(void (*emit)(uint8_t), int8_t* s);
+ *   Inputs: emit = output function, s = NUL terminated string
+ *   Return Value: none
+ *   Function: sends every character of s to emit */
+static void emit_str(void (*emit)(uint8_t), int8_t* s) {
+    while (*s != '\0') {
+        emit(*s);
+        s++;
+    }
+}
+
+/* int32_t vformat(void (*emit)(uint8_t), int8_t* format, int32_t* esp);
+ * Formatting engine shared by printf and the kernel log. Sends each output
+ * character to emit, reading arguments from the stack starting at esp.
  * Only supports the following format strings:
  * %%  - print a literal '%' character
  * %x  - print a number in hexadecimal
@@ -47,15 +154,11 @@ void clear(void) {
  *       the beginning), but I think it's more flexible this way.
  *       Also note: %x is the only conversion specifier that can use
  *       the "#" modifier to alter output. */
-int32_t printf(int8_t *format, ...) {
+int32_t vformat(void (*emit)(uint8_t), int8_t *format, int32_t* esp) {
 
     /* Pointer to the format string */
     int8_t* buf = format;
 
-    /* Stack pointer for the other parameters */
-    int32_t* esp = (void *)&format;
-    esp++;
-
     while (*buf != '\0') {
         switch (*buf) {
             case '%':
@@ -68,7 +171,7 @@ format_char_switch:
                     switch (*buf) {
                         /* Print a literal '%' character */
                         case '%':
-                            putc('%');
+                            emit('%');
                             break;
 
                         /* Use alternate formatting */
@@ -86,7 +189,7 @@ format_char_switch:
                                 int8_t conv_buf[64];
                                 if (alternate == 0) {
                                     itoa(*((uint32_t *)esp), conv_buf, 16);
-                                    puts(conv_buf);
+                                    emit_str(emit, conv_buf);
                                 } else {
                                     int32_t starting_index;
                                     int32_t i;
@@ -96,7 +199,7 @@ format_char_switch:
                                         conv_buf[i] = '0';
                                         i++;
                                     }
-                                    puts(&conv_buf[starting_index]);
+                                    emit_str(emit, &conv_buf[starting_index]);
                                 }
                                 esp++;
                             }
@@ -107,7 +210,7 @@ format_char_switch:
                             {
                                 int8_t conv_buf[36];
                                 itoa(*((uint32_t *)esp), conv_buf, 10);
-                                puts(conv_buf);
+                                emit_str(emit, conv_buf);
                                 esp++;
                             }
                             break;
@@ -123,20 +226,20 @@ format_char_switch:
                                 } else {
                                     itoa(value, conv_buf, 10);
                                 }
-                                puts(conv_buf);
+                                emit_str(emit, conv_buf);
                                 esp++;
                             }
                             break;
 
                         /* Print a single character */
                         case 'c':
-                            putc((uint8_t) *((int32_t *)esp));
+                            emit((uint8_t) *((int32_t *)esp));
                             esp++;
                             break;
 
                         /* Print a NULL-terminated string */
                         case 's':
-                            puts(*((int8_t **)esp));
+                            emit_str(emit, *((int8_t **)esp));
                             esp++;
                             break;
 
@@ -148,7 +251,7 @@ format_char_switch:
                 break;
 
             default:
-                putc(*buf);
+                emit(*buf);
                 break;
         }
         buf++;
@@ -187,7 +290,7 @@ void putc(uint8_t c) {
         }
     } else {
         //cli();
-        char* video_mem = (char*)vmem_Array[write_term_idx];
+        char* video_mem = target_mem();
         uint8_t attrib_idx = (write_term_idx == 0) ? cur_terminal : (write_term_idx);
         if(write_term_idx != 0){
             attrib_idx--;
@@ -213,38 +316,105 @@ void putc(uint8_t c) {
     set_cursor(screen_x, screen_y); //set cursor
 }
 
-/* void shift_screen
+/* int32_t putc_span(const uint8_t* buf, uint32_t n);
+ * Inputs: buf = characters to print, n = number of bytes in buf
+ * Return Value: number of bytes consumed
+ * Function: Same output as calling putc on every byte (NULs are skipped), but
+ * writes runs of printable characters straight into the target terminal's
+ * page and programs the hardware cursor once at the end */
+int32_t putc_span(const uint8_t* buf, uint32_t n) {
+    uint32_t i = 0;
+    int screen_x = get_cursor_x();
+    int screen_y = get_cursor_y();
+    uint16_t* video_mem = (uint16_t*)target_mem();
+    uint16_t* cell;
+    uint8_t attrib_idx = (write_term_idx == 0) ? cur_terminal : (write_term_idx);
+    if(write_term_idx != 0){
+        attrib_idx--;
+    }
+    uint16_t attrib = attrib_Array[attrib_idx] << 8;
+
+    while (i < n) {
+        if (buf[i] == '\0') { //skip NULs like terminal_write always has
+            i++;
+            continue;
+        }
+        if (buf[i] == '\n' || buf[i] == '\r') {
+            i++;
+            screen_x = 0;
+            if (++screen_y > NUM_ROWS - 1) {
+                scroll_screen();
+                video_mem = (uint16_t*)target_mem(); //the screen may have moved
+                screen_y = NUM_ROWS - 1;
+            }
+            continue;
+        }
+
+        //copy everything up to the next control byte or the end of the row
+        cell = video_mem + NUM_COLS * screen_y + screen_x;
+        while (i < n && screen_x < NUM_COLS && buf[i] != '\n' && buf[i] != '\r' && buf[i] != '\0') {
+            *cell++ = attrib | buf[i++];
+            screen_x++;
+        }
+        if (screen_x == NUM_COLS) { //wrapped past the end of the row
+            screen_x = 0;
+            if (++screen_y > NUM_ROWS - 1) {
+                scroll_screen();
+                video_mem = (uint16_t*)target_mem();
+                screen_y = NUM_ROWS - 1;
+            }
+        }
+    }
+    set_cursor(screen_x, screen_y);
+    return i;
+}
+
+/* void scroll_screen
  * Inputs: None
  * Return val: void
- * shifts screen when at bottom of screen
+ * scrolls the target terminal up by one row and blanks the bottom row, leaves
+ * the cursor alone. Moves the terminal's top row down inside its own text
+ * memory and only copies when it runs off the end
  */
-
-void shift_screen(){
-    //cli();
-    char* video_mem = (char*)vmem_Array[write_term_idx];
-    uint32_t i;
+void scroll_screen(){
+    uint16_t* video_mem = (uint16_t*)target_mem();
     uint8_t attrib_idx = (write_term_idx == 0) ? cur_terminal : (write_term_idx);
     if(write_term_idx != 0){
         attrib_idx--;
     }
     uint8_t attrib = attrib_Array[attrib_idx];
-    //sti();
-    for(i = 0; i < (NUM_ROWS-1)*(NUM_COLS); i++){
-        *(uint8_t *)(video_mem + (i << 1)) = *(uint8_t *)(video_mem + ((i + NUM_COLS) << 1));
-        *(uint8_t *)(video_mem + (i << 1) + 1) = *(uint8_t *)(video_mem + ((i + NUM_COLS) << 1) + 1);
-    }
-    for(i = (NUM_ROWS-1)*NUM_COLS; i < NUM_ROWS * NUM_COLS; i++){
-        *(uint8_t *)(video_mem + (i << 1)) = ' ';
-        *(uint8_t *)(video_mem + (i << 1) + 1) = attrib;
+    uint8_t term = target_term();
+    scrollback_push(term, video_mem); //keep the row that is leaving
+    if(!vidmap_mask[term]){
+        if(screen_top[term] + NUM_ROWS < TERM_ROWS){ //room below, just move the start
+            set_screen_top(term, screen_top[term] + 1);
+        }else{ //out of room, rewrap to the start of the terminal's memory
+            memcpy((void*)vmem_Array[term], video_mem + NUM_COLS, (NUM_ROWS-1) * NUM_COLS * 2);
+            set_screen_top(term, 0);
+        }
+        video_mem = (uint16_t*)target_mem();
+    }else{
+        memcpy(video_mem, video_mem + NUM_COLS, (NUM_ROWS-1) * NUM_COLS * 2); //2 bytes per cell, dest is below src
     }
+    memset_word(video_mem + (NUM_ROWS-1) * NUM_COLS, (attrib << 8) | ' ', NUM_COLS);
+}
+
+/* void shift_screen
+ * Inputs: None
+ * Return val: void
+ * shifts screen when at bottom of screen
+ */
+
+void shift_screen(){
+    scroll_screen();
     set_cursor(0, 24);
 }
 
 void init_colors(){
     int i, j;
-    for(i= 1; i < 4; i++){
+    for(i= 0; i < 3; i++){
         char* video_mem = (char*)vmem_Array[i];
-        uint8_t attrib = attrib_Array[i-1];
+        uint8_t attrib = attrib_Array[i];
         for(j = 0; j < (NUM_ROWS)*(NUM_COLS); j++){
             *(uint8_t *)(video_mem + (i << 1) + 1) = attrib;
         }
@@ -541,7 +711,7 @@ int8_t* strncpy(int8_t* dest, const int8_t* src, uint32_t n) {
  * Function: increments video memory. To be used to test rtc */
 void test_interrupts(void) {
     int32_t i;
-    char* video_mem = (char*)vmem_Array[write_term_idx];
+    char* video_mem = target_mem();
     for (i = 0; i < NUM_ROWS * NUM_COLS; i++) {
         video_mem[i << 1]++;
     }
@@ -555,7 +725,7 @@ void test_interrupts(void) {
  */
  void set_cursor(uint8_t x, uint8_t y){
     if(write_term_idx == 0){ //if writing to screen
-        uint16_t char_pos = (y * NUM_COLS) + x; //calculate char pos in mem
+        uint16_t char_pos = (console_visible() - (uint16_t*)VIDEO) + (y * NUM_COLS) + x; //calculate char pos in mem
         outb(0x0E, 0x3D4);  //set register for high 8 bits
         outb((uint8_t) (char_pos >> 8), 0x3D5); //output high 8 bits to cursor
         outb(0x0F, 0x3D4); //set register for low 8 bits
@@ -567,7 +737,7 @@ void test_interrupts(void) {
 void draw_canvas(void) {
     int32_t i;
     //cli();
-    char* video_mem = (char*)vmem_Array[write_term_idx];
+    char* video_mem = target_mem();
     uint8_t attrib = 0xF;
     //sti();
     for (i = 0; i < NUM_ROWS * NUM_COLS; i++) {
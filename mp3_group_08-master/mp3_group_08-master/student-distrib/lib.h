@@ -16,13 +16,20 @@
 #define ATTRIB2     0xD
 #define ATTRIB3     0xE
 
-#define VMEM_TERM1 0xB9000
+/* every terminal has 8kB of real VGA text memory and scrolls inside it by
+ * moving the CRTC start address, 0xBE000-0xBFFFF is left over */
+#define TERM_VMEM_SIZE  0x2000
+#define TERM_ROWS       51 //TERM_VMEM_SIZE / (NUM_COLS * 2)
+#define VMEM_TERM1 0xB8000
 #define VMEM_TERM2 0xBA000
-#define VMEM_TERM3 0xBB000
+#define VMEM_TERM3 0xBC000
+#define VMEM_SPARE 0xBE000
 
 extern uint8_t cur_terminal;
+extern uint8_t vidmap_mask[3];
 
 int32_t printf(int8_t *format, ...);
+int32_t vformat(void (*emit)(uint8_t), int8_t *format, int32_t* esp);
 void putc(uint8_t c);
 int32_t puts(int8_t *s);
 int8_t *itoa(uint32_t value, int8_t* buf, int32_t radix);
@@ -32,6 +39,13 @@ void clear(void);
 void test_interrupts(void);
 void set_cursor(uint8_t x, uint8_t y);
 void shift_screen();
+void scroll_screen();
+uint16_t* term_visible(uint8_t term);
+uint16_t* console_visible(void);
+void console_rewrap(uint8_t term);
+void console_show(uint8_t term);
+void crtc_set_start(const uint16_t* cell);
+int32_t putc_span(const uint8_t* buf, uint32_t n);
 void init_colors();
 void draw_canvas(void);
 
@@ -92,6 +106,17 @@ static inline uint32_t inl(port) {
     return val;
 }
 
+/* Reads the 64-bit time-stamp counter */
+static inline uint64_t rdtsc(void) {
+    uint64_t val;
+    asm volatile ("rdtsc"
+            : "=A"(val)
+            :
+            : "memory"
+    );
+    return val;
+}
+
 /* Writes a byte to a port */
 #define outb(data, port)                \
 do {                                    \
@@ -0,0 +1,428 @@
+#include "line_discipline.h"
+#include "keyboard.h"
+#include "terminal.h"
+#include "history.h"
+#include "lib.h"
+
+#define TAB_SPACES      4
+
+/* characters on screen while a Ctrl+R search is drawn, per terminal */
+static uint32_t search_shown[3];
+
+/* set once enter finishes the line being typed, until a read takes it */
+static uint8_t line_done[3];
+
+/* wait_for_key
+ *
+ * takes the next keystroke for term, sleeping until the keyboard interrupt
+ * queues one
+ * Inputs: terminal, where to put the keystroke
+ * Outputs: None
+ * Side Effects: other terminals run while this one sleeps
+ */
+static void wait_for_key(uint8_t term, uint16_t* key){
+    uint32_t flags;
+    cli_and_save(flags);
+    while(kbd_ring_pop(term, key) == -1){
+        wait_queue_sleep(kbd_ring_wait_queue(term));
+    }
+    restore_flags(flags);
+}
+
+/* replace_line
+ *
+ * erases what is drawn after the prompt and writes text in its place, text is
+ * cut short rather than wrapping onto the next row
+ * Inputs: shown -- characters currently drawn after the prompt
+ *         text -- new text, len -- its length
+ * Outputs: number of characters drawn
+ * Side Effects: leaves the cursor after the new text
+ */
+static uint32_t replace_line(uint32_t shown, const char* text, uint32_t len){
+    int x = get_cursor_x() - shown;
+    int y = get_cursor_y();
+    uint32_t i;
+
+    if(x < 0){
+        x = 0;
+    }
+    if(len > NUM_COLS - 1 - x){
+        len = NUM_COLS - 1 - x;
+    }
+    set_cursor(x, y);
+    for(i = 0; i < len; i++){
+        putc(text[i]);
+    }
+    for(; i < shown; i++){ //blank out the rest of the old text
+        putc(' ');
+    }
+    set_cursor(x + len, y);
+    return len;
+}
+
+/* recall_line
+ *
+ * puts a line from the history on screen and in the line being typed
+ * Inputs: terminal, characters currently drawn after the prompt, the line
+ *         and its length
+ * Outputs: None
+ * Side Effects: replaces the line being typed
+ */
+static void recall_line(terminal_t* t, uint32_t shown, const char* line, uint32_t len){
+    if(len > LINE_MAX_CHARS){
+        len = LINE_MAX_CHARS;
+    }
+    replace_line(shown, line, len);
+    memset(t->keyboard_buf, 0, sizeof(t->keyboard_buf));
+    memcpy(t->keyboard_buf, line, len);
+    t->keyboard_idx = len;
+}
+
+/* draw_search
+ *
+ * draws the search prompt, query and current match where the line goes
+ * Inputs: terminal being searched and its number
+ * Outputs: None
+ * Side Effects: None
+ */
+static void draw_search(terminal_t* t, uint8_t term){
+    history_t* h = &t->history;
+    char text[NUM_COLS + HISTORY_LINE_SIZE];
+    char match[HISTORY_LINE_SIZE];
+    uint32_t len = 0;
+    int32_t match_len = -1;
+
+    memcpy(text, "(search)`", 9);
+    len = 9;
+    memcpy(text + len, h->query, h->query_len);
+    len += h->query_len;
+    memcpy(text + len, "': ", 3);
+    len += 3;
+    if(h->match){
+        match_len = history_get(h, h->match, match);
+    }
+    if(match_len > 0){
+        memcpy(text + len, match, match_len);
+        len += match_len;
+    }
+    search_shown[term] = replace_line(search_shown[term], text, len);
+}
+
+/* end_search
+ *
+ * leaves a search, either taking the match as the line being typed or
+ * putting back what was typed before
+ * Inputs: terminal and its number, whether to take the match
+ * Outputs: None
+ * Side Effects: None
+ */
+static void end_search(terminal_t* t, uint8_t term, uint8_t accept){
+    history_t* h = &t->history;
+    char line[HISTORY_LINE_SIZE];
+    int32_t len;
+
+    h->searching = 0;
+    if(accept && h->match && (len = history_get(h, h->match, line)) != -1){
+        recall_line(t, search_shown[term], line, len);
+        return;
+    }
+    replace_line(search_shown[term], t->keyboard_buf, t->keyboard_idx);
+}
+
+/* search_key
+ *
+ * handles a key pressed during a Ctrl+R search. Typing narrows the search
+ * from the current match, Ctrl+R again looks further back, backspace widens
+ * it, escape gives up, and anything else takes the match
+ * Inputs: terminal and its number, keystroke
+ * Outputs: 1 if the key was used up, 0 if it should be handled normally too
+ * Side Effects: None
+ */
+static uint8_t search_key(terminal_t* t, uint8_t term, uint16_t key){
+    history_t* h = &t->history;
+    int32_t found;
+    char c;
+
+    switch(KEY_CODE(key)){
+        case 0x01: //ESCAPE
+            end_search(t, term, 0);
+            return 1;
+        case 0x1C: //ENTER runs the match
+            end_search(t, term, 1);
+            return 0;
+        case 0x0E: //BACKSPACE
+            if(h->query_len > 0){
+                h->query_len--;
+            }
+            found = history_search(h, h->query, h->query_len, 1);
+            h->match = (found == -1) ? 0 : found;
+            draw_search(t, term);
+            return 1;
+    }
+    if((key & KEY_CTRL) && KEY_CODE(key) == 0x13){ //Ctrl+R again, next older match
+        found = history_search(h, h->query, h->query_len, h->match + 1);
+        if(found != -1){
+            h->match = found;
+        }
+        draw_search(t, term);
+        return 1;
+    }
+    if(!(key & KEY_CTRL) && (c = key_char(key))){
+        if(h->query_len < HISTORY_QUERY_SIZE){
+            h->query[h->query_len++] = c;
+            found = history_search(h, h->query, h->query_len, h->match ? h->match : 1);
+            if(found != -1){ //no match keeps the old one on screen
+                h->match = found;
+            }
+            draw_search(t, term);
+        }
+        return 1;
+    }
+    end_search(t, term, 1);
+    return 1;
+}
+
+/* edit_line
+ *
+ * applies one keystroke to the line being typed and echoes it
+ * Inputs: terminal and its number, keystroke
+ * Outputs: 1 once enter finishes the line, 0 otherwise
+ * Side Effects: draws on term's screen
+ */
+static uint8_t edit_line(terminal_t* t, uint8_t term, uint16_t key){
+    char line[HISTORY_LINE_SIZE];
+    int32_t len, i;
+    int x, y;
+    char c;
+
+    //keys typed during a Ctrl+R search edit the search instead of the line
+    if(t->history.searching && search_key(t, term, key)){
+        return 0;
+    }
+
+    switch(KEY_CODE(key)){
+        case 0x1C: //ENTER
+            putc('\n');
+            return 1;
+        case 0x0E: //BACKSPACE
+            x = get_cursor_x();
+            y = get_cursor_y();
+            if(t->keyboard_idx > 0 && (x > 0 || y > 0)){ //do not delete if no chars in buffer or at beginning of screen
+                if(x == 0){ //if at beginning of line go back to end of previous line
+                    x = NUM_COLS - 1;
+                    y--;
+                } else{
+                    x--;
+                }
+                set_cursor(x, y);
+                putc(' '); //replace char with space
+                t->keyboard_buf[--t->keyboard_idx] = 0;
+                set_cursor(x, y);
+            }
+            return 0;
+        case 0x0F: //TAB
+            for(i = 0; i < TAB_SPACES; i++){
+                putc(' ');
+            }
+            return 0;
+        case 0x48: //UP ARROW
+            len = history_prev(&t->history, t->keyboard_buf, t->keyboard_idx, line);
+            if(len != -1){
+                recall_line(t, t->keyboard_idx, line, len);
+            }
+            return 0;
+        case 0x50: //DOWN ARROW
+            len = history_next(&t->history, line);
+            if(len != -1){
+                recall_line(t, t->keyboard_idx, line, len);
+            }
+            return 0;
+    }
+
+    if(key & KEY_CTRL){
+        if(KEY_CODE(key) == 0x13){ //Ctrl+R starts a reverse search
+            t->history.searching = 1;
+            t->history.query_len = 0;
+            t->history.match = 0;
+            search_shown[term] = t->keyboard_idx;
+            draw_search(t, term);
+        } else if(KEY_CODE(key) == 0x26){ //Ctrl+L clears the screen
+            clear_screen();
+        }
+        return 0;
+    }
+
+    c = key_char(key);
+    if(c && t->keyboard_idx < LINE_MAX_CHARS){
+        t->keyboard_buf[t->keyboard_idx++] = c;
+        putc(c);
+    }
+    return 0;
+}
+
+/* raw_byte
+ *
+ * what a keystroke reads as in raw mode: its character, a control character
+ * for Ctrl+letter, or 0x80 | scan code for keys with no character
+ * Inputs: keystroke
+ * Outputs: the byte
+ * Side Effects: None
+ */
+static uint8_t raw_byte(uint16_t key){
+    char c = key_char(key);
+
+    if(c && (key & KEY_CTRL) && ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))){
+        return c & 0x1F;
+    }
+    if(c){
+        return c;
+    }
+    switch(KEY_CODE(key)){
+        case 0x1C: return '\n';
+        case 0x0E: return '\b';
+        case 0x0F: return '\t';
+        case 0x01: return 0x1B; //escape
+    }
+    return 0x80 | KEY_CODE(key);
+}
+
+/* read_line
+ *
+ * canonical mode, edits and echoes keystrokes until enter
+ * Inputs: terminal, user buffer and its size
+ * Outputs: number of bytes read, including the newline
+ * Side Effects: adds shell commands to the history
+ */
+static int32_t read_line(uint8_t term, uint8_t* buf, int32_t nbytes){
+    terminal_t* t = &terminal_struct[term];
+    uint32_t flags;
+    uint16_t key;
+    int32_t n;
+
+    //ldisc_poll may already have finished the line
+    while(!line_done[term]){
+        wait_for_key(term, &key);
+
+        //echo goes to term's own screen, keep other writers off write_term_idx meanwhile
+        cli_and_save(flags);
+        write_term_idx = (term != cur_terminal) ? term + 1 : 0;
+        line_done[term] = edit_line(t, term, key);
+        write_term_idx = 0;
+        restore_flags(flags);
+    }
+    line_done[term] = 0;
+
+    //save shell commands for Up/Down and Ctrl+R
+    if(shell_mask[(uint8_t)current_pid]){
+        history_add(&t->history, t->keyboard_buf, t->keyboard_idx);
+    }
+
+    n = t->keyboard_idx;
+    if(n > nbytes - 1){
+        n = nbytes - 1;
+    }
+    memcpy(buf, t->keyboard_buf, n);
+    buf[n] = '\n';
+
+    //reset the line being typed
+    memset(t->keyboard_buf, 0, sizeof(t->keyboard_buf));
+    t->keyboard_idx = 0;
+    return n + 1;
+}
+
+/* read_raw
+ *
+ * raw mode, waits for at least one keystroke and returns every one that is
+ * already queued, nothing is echoed
+ * Inputs: terminal, user buffer and its size
+ * Outputs: number of bytes read
+ * Side Effects: None
+ */
+static int32_t read_raw(uint8_t term, uint8_t* buf, int32_t nbytes){
+    uint16_t key;
+    int32_t n = 0;
+
+    wait_for_key(term, &key);
+    buf[n++] = raw_byte(key);
+    while(n < nbytes && kbd_ring_pop(term, &key) != -1){
+        buf[n++] = raw_byte(key);
+    }
+    return n;
+}
+
+/* ldisc_read
+ *
+ * reads from a terminal, the editing and echo run here in the reader rather
+ * than in the keyboard interrupt
+ * Inputs: terminal, user buffer and its size
+ * Outputs: number of bytes read, -1 on bad input
+ * Side Effects: sleeps until there is input
+ */
+int32_t ldisc_read(uint8_t term, uint8_t* buf, int32_t nbytes){
+    if(term > 2 || buf == NULL || nbytes < 0){
+        return -1;
+    }
+    if(nbytes == 0){
+        return 0;
+    }
+    if(terminal_struct[term].mode == TERM_MODE_RAW){
+        return read_raw(term, buf, nbytes);
+    }
+    return read_line(term, buf, nbytes);
+}
+
+/* ldisc_poll
+ *
+ * whether a read of term would return without sleeping. In canonical mode the
+ * keys already queued are edited and echoed here, so a line finishes even
+ * while its reader is waiting on something else
+ * Inputs: terminal, nonzero to wait on the keyboard ring if not ready
+ * Outputs: 1 if ready, 0 if not
+ * Side Effects: call with interrupts off
+ */
+int32_t ldisc_poll(uint8_t term, int32_t wait){
+    terminal_t* t;
+    uint16_t key;
+    int32_t ready;
+
+    if(term > 2){
+        return 0;
+    }
+    t = &terminal_struct[term];
+    if(t->mode == TERM_MODE_RAW){
+        ready = kbd_ring_pending(term) ? 1 : 0;
+    } else{
+        write_term_idx = (term != cur_terminal) ? term + 1 : 0;
+        while(!line_done[term] && kbd_ring_pop(term, &key) != -1){
+            line_done[term] = edit_line(t, term, key);
+        }
+        write_term_idx = 0;
+        ready = line_done[term];
+    }
+    if(!ready && wait){
+        wait_queue_add(kbd_ring_wait_queue(term));
+    }
+    return ready;
+}
+
+/* ldisc_reset
+ *
+ * back to canonical mode with an empty line and nothing queued, used when a
+ * program exits so the shell does not get its leftovers
+ * Inputs: terminal
+ * Outputs: None
+ * Side Effects: None
+ */
+void ldisc_reset(uint8_t term){
+    terminal_t* t;
+    if(term > 2){
+        return;
+    }
+    t = &terminal_struct[term];
+    t->mode = TERM_MODE_CANON;
+    t->history.searching = 0;
+    memset(t->keyboard_buf, 0, sizeof(t->keyboard_buf));
+    t->keyboard_idx = 0;
+    line_done[term] = 0;
+    kbd_ring_flush(term);
+}
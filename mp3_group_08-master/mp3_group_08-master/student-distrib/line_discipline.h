@@ -0,0 +1,21 @@
+#ifndef _LINE_DISCIPLINE_H
+#define _LINE_DISCIPLINE_H
+
+#include "types.h"
+
+#define LINE_MAX_CHARS      72      // longest line canonical mode lets you type
+
+/* terminal modes, set with ioctl(fd, TERM_SETMODE, mode) */
+#define TERM_MODE_CANON     0       // line editing and echo, read returns a whole line
+#define TERM_MODE_RAW       1       // no echo, read returns keystrokes as soon as there are any
+
+/* reads from term in its current mode, runs in the reading process */
+int32_t ldisc_read(uint8_t term, uint8_t* buf, int32_t nbytes);
+
+/* 1 if a read of term would not sleep, edits queued keys in canonical mode */
+int32_t ldisc_poll(uint8_t term, int32_t wait);
+
+/* puts term back in canonical mode with nothing typed or queued */
+void ldisc_reset(uint8_t term);
+
+#endif /* _LINE_DISCIPLINE_H */
@@ -3,6 +3,8 @@
 #include "lib.h"
 #include "paging.h"
 #include "terminal.h"
+#include "input.h"
+#include "irq_stats.h"
 
 uint32_t mouse_x = 0;
 uint32_t mouse_y = 0;
@@ -10,6 +12,20 @@ uint8_t prev_char = 0;
 uint8_t paint[3] = {0, 0, 0};
 uint8_t right_click = 0;
 
+static uint8_t packet[4];        // bytes of the packet being put together
+static uint8_t packet_idx = 0;  // next byte of packet
+static uint8_t packet_size = 3; // 4 once an IntelliMouse wheel is turned on
+
+static mouse_event_t event_queue[MOUSE_QUEUE_SIZE];
+static volatile uint32_t queue_head = 0;   // total events queued by the IRQ
+static volatile uint32_t queue_tail = 0;   // total events handled by the bottom half
+static uint32_t queue_dropped = 0;
+
+static uint8_t mouse_command(uint8_t cmd);
+static void mouse_queue_push(uint8_t* pkt);
+static void mouse_process(const mouse_event_t* ev);
+
+
 void mouse_init(void) {
     uint8_t status;
 
@@ -35,46 +51,144 @@ void mouse_init(void) {
 
     //aux input enable command (optional)
 
+    //IntelliMouse knock: sample rates 200, 100, 80 turn on the wheel
+    mouse_command(MOUSE_SET_RATE);
+    mouse_command(200);
+    mouse_command(MOUSE_SET_RATE);
+    mouse_command(100);
+    mouse_command(MOUSE_SET_RATE);
+    mouse_command(80);
+    mouse_command(MOUSE_GET_ID);
+    read_wait();
+    if (inb(MOUSE_DATA) == MOUSE_ID_WHEEL) {
+        packet_size = 4;
+    }
+
+    //enable streaming
+    mouse_command(MOUSE_ENABLE);
+
+    enable_irq(12); // 12 for mouse
+}
+
+/* mouse_command
+ * 
+ * sends one byte to the mouse (through 0xD4) and waits for its ACK, only used
+ * while setting up with irq12 still masked
+ * Inputs: command or argument byte
+ * Outputs: the mouse's reply, 0xFA on success
+ * Side Effects: None
+ */
+static uint8_t mouse_command(uint8_t cmd) {
     //send d4 to 0x64
     write_wait();
     outb(MOUSE_SELECT, MOUSE_STATUS);
-    //enable streaming f4 to 0x60
     write_wait();
-    outb(0xF4, MOUSE_DATA);
-    //maybe check ACK
+    outb(cmd, MOUSE_DATA);
     read_wait();
-    inb(MOUSE_DATA);
-
-    enable_irq(12); // 12 for mouse
+    return inb(MOUSE_DATA);
 }
 
+/* mouse_handler
+ * 
+ * IRQ12, takes the one byte the controller has and feeds it to the packet
+ * state machine. A finished packet is queued for mouse_bottom_half
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: one port read
+ */
 void mouse_handler(void) {
-    uint8_t status;
-    int32_t delta_x;
-    int32_t delta_y;
-    uint8_t paint_flag = 0;
+    uint8_t data;
 
     send_eoi(12);
+    data = inb(MOUSE_DATA);
 
-    read_wait();
-    status = inb(MOUSE_DATA);
+    //the first byte always has bit 3 set, anything else means we lost sync
+    if (packet_idx == 0 && !(data & MOUSE_SYNC_BIT)) {
+        return;
+    }
+    packet[packet_idx++] = data;
+    if (packet_idx < packet_size) {
+        return;
+    }
+    packet_idx = 0;
 
-    if (((status >> 7) & INPUT_BIT) || ((status >> 6) & INPUT_BIT)) {
+    //drop packets whose x or y overflowed
+    if (((packet[0] >> 7) & INPUT_BIT) || ((packet[0] >> 6) & INPUT_BIT)) {
         return;
-    };
+    }
+    mouse_queue_push(packet);
+}
 
-    read_wait();
-    delta_x = inb(MOUSE_DATA);
+/* mouse_queue_push
+ * 
+ * turns a packet into an event, hands it to the mouse device and adds it to
+ * the queue, only called from the IRQ
+ * Inputs: the packet
+ * Outputs: None
+ * Side Effects: counts a drop when the queue is full
+ */
+static void mouse_queue_push(uint8_t* pkt) {
+    mouse_event_t ev;
+    ev.buttons = pkt[0] & MOUSE_BUTTONS;
+    ev.dx = pkt[1] - ((pkt[0] << 4) & 0x100);
+    ev.dy = pkt[2] - ((pkt[0] << 3) & 0x100);
+    ev.dz = (packet_size == 4) ? (int8_t)(pkt[3] << 4) >> 4 : 0; //low 4 bits, signed
+
+    //programs with the mouse device open get it even if the cursor work is behind
+    input_report_mouse(cur_terminal, ev.buttons, ev.dx, ev.dy, ev.dz, irq_entry_tsc[12]);
+
+    if (queue_head - queue_tail == MOUSE_QUEUE_SIZE) {
+        queue_dropped++;
+        return;
+    }
+    event_queue[queue_head & (MOUSE_QUEUE_SIZE - 1)] = ev;
+    asm volatile("" ::: "memory"); //event must be in place before head moves
+    queue_head++;
+}
 
-    read_wait();
-    delta_y = inb(MOUSE_DATA);
+/* mouse_bottom_half
+ * 
+ * moves the cursor and paints for every queued event, called from the pit
+ * tick with interrupts off so the mouse IRQ stays short
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: draws on the screen
+ */
+void mouse_bottom_half(void) {
+    while (queue_tail != queue_head) {
+        mouse_event_t ev = event_queue[queue_tail & (MOUSE_QUEUE_SIZE - 1)];
+        queue_tail++;
+        mouse_process(&ev);
+    }
+}
+
+/* mouse_dropped
+ * 
+ * Inputs: None
+ * Outputs: number of events lost because the queue was full
+ * Side Effects: None
+ */
+uint32_t mouse_dropped(void) {
+    return queue_dropped;
+}
 
-    if(!typing_mask[cur_terminal] && !paint[cur_terminal]){
+/* mouse_process
+ * 
+ * cursor and paint work for one event, this used to run inside the IRQ
+ * Inputs: the event
+ * Outputs: None
+ * Side Effects: draws on the screen
+ */
+static void mouse_process(const mouse_event_t* ev) {
+    uint8_t status = ev->buttons;
+    uint8_t paint_flag = 0;
+
+    if(vidmap_mask[cur_terminal] && !paint[cur_terminal]){ //program draws on the screen itself
         return;
     }
 
-    int32_t rel_x = delta_x - ((status << 4) & 0x100);
-    int32_t rel_y = delta_y - ((status << 3) & 0x100);
+    int32_t rel_x = ev->dx;
+    int32_t rel_y = ev->dy;
 
     rel_x /= 4;
     rel_y /= 4;
@@ -94,7 +208,7 @@ void mouse_handler(void) {
         new_mouse_y = 24;
     }
 
-    char* video_mem = (char*)vmem_Array[0];
+    char* video_mem = (char*)console_visible();
 
     //differentiate paint or no paint
     if (((status >> 1) & INPUT_BIT)) { //right click detected
@@ -109,8 +223,7 @@ void mouse_handler(void) {
                 typing_mask[cur_terminal] = 1;
                 clear_screen();
                 //shift_screen();
-                terminal_t* active_term = &(terminal_struct[cur_terminal]);
-                active_term->enter_flag = 1;
+                kbd_ring_push(cur_terminal, 0x1C); //enter, so the shell prompts again
             } else {
                 //MAKE SCREEN WHITE
 
@@ -129,10 +242,6 @@ void mouse_handler(void) {
         right_click = 0;
     }
 
-    //change paging
-    uint32_t paging_status = vidmap_page_table[VIDMEM_INDEX].physical_address;
-    vidmap_page_table[VIDMEM_INDEX].physical_address = VIDMEM_INDEX;
-
     //paint and left click pressed
     if (paint[cur_terminal] && (status & INPUT_BIT)) {
         *(uint8_t *)(video_mem + ((NUM_COLS * mouse_y + mouse_x) << 1)) = 0xDB;
@@ -160,9 +269,6 @@ void mouse_handler(void) {
         *(uint8_t *)(video_mem + ((NUM_COLS * 0 + 4) << 1)) = 'T';
     }
 
-    //restore paging
-    vidmap_page_table[VIDMEM_INDEX].physical_address = paging_status;
-
     mouse_x = new_mouse_x;
     mouse_y = new_mouse_y;
 
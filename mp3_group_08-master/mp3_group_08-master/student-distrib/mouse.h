@@ -11,14 +11,37 @@
 #define MOUSE_BITS 0x21
 #define RANDOM 0x22
 
-extern uint32_t vmem_Array[4];
+#define MOUSE_SYNC_BIT      0x08    // always set in the first byte of a packet
+#define MOUSE_BUTTONS       0x07    // left, right, middle
+#define MOUSE_QUEUE_SIZE    32      // events waiting for the bottom half, must be a power of 2
+#define MOUSE_SET_RATE      0xF3
+#define MOUSE_GET_ID        0xF2
+#define MOUSE_ENABLE        0xF4
+#define MOUSE_ID_WHEEL      3       // IntelliMouse, sends a 4th byte with the wheel
+
+// one decoded packet
+typedef struct mouse_event_t {
+    int16_t dx;         // right is positive
+    int16_t dy;         // up is positive
+    int8_t dz;          // wheel, 0 without an IntelliMouse
+    uint8_t buttons;    // MOUSE_BUTTONS bits
+} mouse_event_t;
+
+extern uint32_t vmem_Array[3];
 extern uint8_t typing_mask[3];
 extern uint8_t shell_mask[6]; 
 
 void mouse_init();
 
+/* irq12, one byte of a packet per interrupt */
 void mouse_handler();
 
+/* handles queued events, called from the pit tick */
+void mouse_bottom_half(void);
+
+/* events lost to a full queue */
+uint32_t mouse_dropped(void);
+
 void read_wait();
 
 void write_wait();
@@ -1,6 +1,27 @@
 #include "paging.h"
+#include "system_calls.h"
+#include "shm.h"
+#include "file_system.h"
 
 #define PDM_SIZE         1024
+#define USER_PDE         32         // program memory, 128MB-132MB
+#define USER_FRAME(pid)  ((2 + (pid)) << 10)  // first 4kB page of pid's 4MB physical frame
+#define PTE_COW          0x1        // AVL bit: read only because it is shared, a write copies it
+#define PTE_LAZY         0x2        // AVL bit: not present yet, the first touch maps a zeroed page
+#define PTE_MMAP         0x4        // AVL bit: part of a mapping, only munmap lets it go
+#define USER_PAGE(addr)  (((addr) - USRMEM_BOTTOM) >> 12)  // page index in program memory
+#define STACK_PAGE       (PDM_SIZE - USER_STACK_PAGES)      // lowest page of the stack region
+#define COPY_SRC_PAGE    0xC0       // scratch kernel pages past text memory for copying a physical page, PDE 0 always maps them
+#define COPY_DST_PAGE    0xC1
+// a page of a file mapping: read only without being copy-on-write
+#define FILE_PAGE(pte)   ((pte).P && !(pte).R_W && ((pte).AVL & (PTE_MMAP | PTE_COW)) == PTE_MMAP)
+
+/* program memory of each process in 4kB pages. Virtual page i of a process
+ * is always physical page i of some process's frame: its own, or an
+ * ancestor's it still shares after fork. Nobody else ever maps page i of a
+ * frame whose process is not mapping it itself, so that slot is where a copy goes.
+ * Pages of a file mapping are the exception, they map the file system image */
+static page_table_entry_t user_page_table[MAX_PROCESSES][PDM_SIZE] __attribute__((aligned(4096)));
 /* paging_init
  * 
  * Initializes the paging system, sets up page directory and page tables.
@@ -65,23 +86,17 @@ void paging_init(){
         first_page_table[i].physical_address = i;
     }
 
-    first_page_table[184].P = 1; // video memory location
-    first_page_table[184].G = 1;
-    
-    first_page_table[185].P = 1;    // terminal 1 paging allocation
-    first_page_table[185].G = 1;
-
-    first_page_table[186].P = 1;     // terminal 2 paging allocation
-    first_page_table[186].G = 1;
-
-    first_page_table[187].P = 1;     // terminal 3 paging allocation
-    first_page_table[187].G = 1;
+    // VGA text memory, two pages per terminal starting at 184 and a spare at 190-191
+    for (i = 184; i < 192; i++){
+        first_page_table[i].P = 1;
+        first_page_table[i].G = 1;
+    }
 
-    // fill out 4kB page table for vidmap
+    // fill out 4kB page table for vidmap, its own directory entry so the kernel's view of text memory never changes
     for (i = 0; i < PDM_SIZE; i++){
         vidmap_page_table[i].P = 0;
-        vidmap_page_table[i].G = 1;
-        vidmap_page_table[i].U_S = 0;
+        vidmap_page_table[i].G = 0;
+        vidmap_page_table[i].U_S = 1;
         vidmap_page_table[i].R_W = 1; // should be able to read and write
         vidmap_page_table[i].PCD = 0;
         vidmap_page_table[i].PWT = 0;
@@ -107,7 +122,7 @@ void paging_init(){
  * Maps program memory for a specific process.
  * Inputs: int32_t pid - process ID of the program
  * Outputs: 0 on success, or -1 on failure.
- * Side Effects: Maps program memory for the specified process in the page directory.
+ * Side Effects: Maps program memory and the process's shared memory segments in the page directory.
  */
 int32_t map_program_mem(int32_t pid){
     if(pid < 0){
@@ -115,15 +130,456 @@ int32_t map_program_mem(int32_t pid){
     }
 
     // sets up paging for execute/halt (32 represents the corect index for program memeory)
-    page_directory[32].page_directory_union.mb.physical_address = 2 + pid;
-    page_directory[32].page_directory_union.mb.P = 1;
-    page_directory[32].page_directory_union.mb.U_S = 1;
-    flush_tlb();
+    // threads run in the frame of the process they belong to
+    pcb_block_t* proc = pcb_array[pid]->proc;
+    page_directory[USER_PDE].page_directory_union.kb.physical_address = ((uint32_t)user_page_table[proc->processid]) >> 12;
+    page_directory[USER_PDE].page_directory_union.kb.PS = 0;
+    page_directory[USER_PDE].page_directory_union.kb.P = 1;
+    page_directory[USER_PDE].page_directory_union.kb.U_S = 1;
+    page_directory[USER_PDE].page_directory_union.kb.R_W = 1; // the page table entries decide
+    shm_map(proc->shm_mask); // flushes the tlb
 
     return 0; //pass
 }
 
 
+/* user_virt_to_phys
+ * 
+ * Walks the page directory the way the mmu would for a user access.
+ * Inputs: uint32_t addr - virtual address in the running process
+ * Outputs: the physical address, or 0 if addr is not mapped for user access.
+ * Side Effects: None
+ */
+uint32_t user_virt_to_phys(uint32_t addr){
+    page_directory_entry_t* pde = &page_directory[addr >> 22]; // top 10 bits pick the directory entry
+    page_table_entry_t* pte;
+
+    if (!pde->page_directory_union.mb.P || !pde->page_directory_union.mb.U_S) return 0;
+    if (pde->page_directory_union.mb.PS) {
+        return (pde->page_directory_union.mb.physical_address << 22) | (addr & 0x3FFFFF);
+    }
+
+    pte = &((page_table_entry_t*)(pde->page_directory_union.kb.physical_address << 12))[(addr >> 12) & 0x3FF];
+    if (!pte->P || !pte->U_S) return 0;
+    return (pte->physical_address << 12) | (addr & 0xFFF);
+}
+
+
+/* invlpg
+ * 
+ * Drops the TLB entry of one kernel page after its page table entry changed.
+ * Inputs: uint32_t page - virtual page number
+ * Outputs: None
+ * Side Effects: None
+ */
+static inline void invlpg(uint32_t page){
+    asm volatile ("invlpg (%0)" : : "r"(page << 12) : "memory");
+}
+
+
+/* copy_phys_page
+ * 
+ * Copies one physical 4kB page to another through two scratch kernel mappings.
+ * Inputs: uint32_t dst, src - physical page numbers
+ * Outputs: None
+ * Side Effects: call with interrupts off
+ */
+static void copy_phys_page(uint32_t dst, uint32_t src){
+    first_page_table[COPY_SRC_PAGE].physical_address = src;
+    first_page_table[COPY_SRC_PAGE].P = 1;
+    first_page_table[COPY_DST_PAGE].physical_address = dst;
+    first_page_table[COPY_DST_PAGE].P = 1;
+    invlpg(COPY_SRC_PAGE);
+    invlpg(COPY_DST_PAGE);
+
+    memcpy((void*)(COPY_DST_PAGE << 12), (void*)(COPY_SRC_PAGE << 12), 1 << 12);
+
+    first_page_table[COPY_SRC_PAGE].P = 0;
+    first_page_table[COPY_DST_PAGE].P = 0;
+    invlpg(COPY_SRC_PAGE);
+    invlpg(COPY_DST_PAGE);
+}
+
+
+/* zero_phys_page
+ * 
+ * Clears one physical 4kB page through a scratch kernel mapping.
+ * Inputs: uint32_t page - physical page number
+ * Outputs: None
+ * Side Effects: call with interrupts off or on a page nobody else can map yet
+ */
+static void zero_phys_page(uint32_t page){
+    first_page_table[COPY_DST_PAGE].physical_address = page;
+    first_page_table[COPY_DST_PAGE].P = 1;
+    invlpg(COPY_DST_PAGE);
+
+    memset((void*)(COPY_DST_PAGE << 12), 0, 1 << 12);
+
+    first_page_table[COPY_DST_PAGE].P = 0;
+    invlpg(COPY_DST_PAGE);
+}
+
+
+/* load_phys_page
+ * 
+ * Fills one physical 4kB page with n bytes from the kernel, zeroes the rest.
+ * Inputs: uint32_t page - physical page number
+ *         const void* src - bytes to copy, uint32_t n - how many
+ * Outputs: None
+ * Side Effects: call with interrupts off
+ */
+static void load_phys_page(uint32_t page, const void* src, uint32_t n){
+    first_page_table[COPY_DST_PAGE].physical_address = page;
+    first_page_table[COPY_DST_PAGE].P = 1;
+    invlpg(COPY_DST_PAGE);
+
+    memset((void*)(COPY_DST_PAGE << 12), 0, 1 << 12);
+    memcpy((void*)(COPY_DST_PAGE << 12), src, n);
+
+    first_page_table[COPY_DST_PAGE].P = 0;
+    invlpg(COPY_DST_PAGE);
+}
+
+
+/* user_pages_init
+ * 
+ * Lays out a new process's program memory on its own frame: the image is
+ * present, its bss and the stack region are zero filled as they are touched,
+ * everything else is free for brk and mmap.
+ * Inputs: int32_t pid - the new process
+ *         uint32_t image_end - end of the file copied in at USER_IMAGE_ADDR
+ *         uint32_t bss_end - end of the program's memory, at least image_end
+ * Outputs: None
+ * Side Effects: Zeroes the last image page, the copy fills the rest of it.
+ */
+void user_pages_init(int32_t pid, uint32_t image_end, uint32_t bss_end){
+    int i;
+
+    for (i = 0; i < PDM_SIZE; i++){
+        user_page_table[pid][i].P = 0;
+        user_page_table[pid][i].U_S = 1;
+        user_page_table[pid][i].R_W = 1;
+        user_page_table[pid][i].PCD = 0;
+        user_page_table[pid][i].PWT = 0;
+        user_page_table[pid][i].A = 0;
+        user_page_table[pid][i].D = 0;
+        user_page_table[pid][i].PAT = 0;
+        user_page_table[pid][i].G = 0;
+        user_page_table[pid][i].AVL = 0;
+        user_page_table[pid][i].physical_address = USER_FRAME(pid) + i;
+
+        if (i >= USER_PAGE(USER_IMAGE_ADDR) && i <= USER_PAGE(image_end - 1)){
+            user_page_table[pid][i].P = 1;
+        } else if ((i > USER_PAGE(image_end - 1) && i <= USER_PAGE(bss_end - 1)) || i >= STACK_PAGE){
+            user_page_table[pid][i].AVL = PTE_LAZY;
+        }
+    }
+    zero_phys_page(USER_FRAME(pid) + USER_PAGE(image_end - 1));
+}
+
+
+/* user_pages_fork
+ * 
+ * Gives the child the parent's pages, read only in both until one of them writes.
+ * File mappings stay shared, blocks that had to be copied are copied again.
+ * Inputs: int32_t parent - process being forked
+ *         int32_t child - its new copy, whose frame is not used yet
+ * Outputs: None
+ * Side Effects: Flushes the TLB.
+ */
+void user_pages_fork(int32_t parent, int32_t child){
+    int i;
+
+    for (i = 0; i < PDM_SIZE; i++){
+        if (FILE_PAGE(user_page_table[parent][i])){
+            user_page_table[child][i] = user_page_table[parent][i];
+            if (user_page_table[parent][i].physical_address == USER_FRAME(parent) + i){ // a copied block
+                copy_phys_page(USER_FRAME(child) + i, USER_FRAME(parent) + i);
+                user_page_table[child][i].physical_address = USER_FRAME(child) + i;
+            }
+            continue;
+        }
+        if (user_page_table[parent][i].P){
+            user_page_table[parent][i].R_W = 0;
+            user_page_table[parent][i].AVL |= PTE_COW;
+        }
+        user_page_table[child][i] = user_page_table[parent][i];
+    }
+    flush_tlb();
+}
+
+
+/* cow_move_home
+ * 
+ * Gives a process its own writable copy of page i in its own frame.
+ * Inputs: int32_t pid - the process, uint32_t i - page index in program memory
+ * Outputs: None
+ * Side Effects: caller flushes the TLB
+ */
+static void cow_move_home(int32_t pid, uint32_t i){
+    uint32_t home = USER_FRAME(pid) + i;
+
+    if (user_page_table[pid][i].physical_address != home){
+        copy_phys_page(home, user_page_table[pid][i].physical_address);
+        user_page_table[pid][i].physical_address = home;
+    }
+    user_page_table[pid][i].R_W = 1;
+    user_page_table[pid][i].AVL &= ~PTE_COW;
+}
+
+
+/* cow_evict_sharers
+ * 
+ * Moves everyone still sharing page i of owner's frame to a copy of their own.
+ * Inputs: int32_t owner - process whose frame holds the page, uint32_t i - page index
+ * Outputs: None
+ * Side Effects: caller flushes the TLB
+ */
+static void cow_evict_sharers(int32_t owner, uint32_t i){
+    int32_t pid;
+
+    for (pid = 0; pid < MAX_PROCESSES; pid++){
+        if (pid != owner && user_page_table[pid][i].P &&
+            user_page_table[pid][i].physical_address == USER_FRAME(owner) + i){
+            cow_move_home(pid, i);
+        }
+    }
+}
+
+
+/* user_page_fault
+ * 
+ * Resolves a fault on program memory that is only there lazily. A missing
+ * page reserved by the loader, brk or mmap gets a zeroed page of its own
+ * frame. A write to a copy-on-write page copies it: a process sharing an
+ * ancestor's page copies it into its own frame, a process writing a page of
+ * its own frame moves the sharers out instead, so the page never has to
+ * change place for its owner.
+ * Inputs: uint32_t addr - faulting address (cr2)
+ *         uint32_t err - page fault error code
+ * Outputs: 0 if the access can be retried, -1 if this is a real fault.
+ * Side Effects: Flushes the TLB.
+ */
+int32_t user_page_fault(uint32_t addr, uint32_t err){
+    uint32_t flags, i;
+    int32_t pid;
+    page_table_entry_t* pte;
+
+    if (current_pid < 0 || addr < USRMEM_BOTTOM || addr >= USRMEM_TOP) return -1;
+
+    pid = pcb_array[(uint8_t)current_pid]->proc->processid;
+    i = USER_PAGE(addr);
+    pte = &user_page_table[pid][i];
+
+    cli_and_save(flags);
+    if (!pte->P && (pte->AVL & PTE_LAZY)){
+        // nobody maps this slot of our frame while our own entry is not present
+        zero_phys_page(USER_FRAME(pid) + i);
+        pte->physical_address = USER_FRAME(pid) + i;
+        pte->AVL &= ~PTE_LAZY;
+        pte->R_W = 1;
+        pte->P = 1;
+    } else if (pte->P && (err & PF_WRITE) && (pte->AVL & PTE_COW)){
+        if (pte->physical_address == USER_FRAME(pid) + i){
+            cow_evict_sharers(pid, i);
+        }
+        cow_move_home(pid, i);
+    } else{
+        restore_flags(flags);
+        return -1;
+    }
+    flush_tlb();
+    restore_flags(flags);
+    return 0;
+}
+
+
+/* user_page_touch
+ * 
+ * Faults in a lazy page before the kernel hands its address to something
+ * that only looks at present pages.
+ * Inputs: uint32_t addr - address in the running process
+ * Outputs: 0 if it is mapped now, -1 if it is not program memory in use.
+ * Side Effects: None
+ */
+int32_t user_page_touch(uint32_t addr){
+    if (user_virt_to_phys(addr)) return 0;
+    return user_page_fault(addr, 0);
+}
+
+
+/* user_page_touch_write
+ * 
+ * Like user_page_touch, but also breaks copy-on-write the way a store would,
+ * so the frame returned by user_virt_to_phys afterwards stays the process's own.
+ * Shared memory and vidmap are mapped outside program memory and never copied.
+ * Inputs: uint32_t addr - address in the running process
+ * Outputs: 0 if it is mapped now, -1 if it is not mapped for the process.
+ * Side Effects: may copy the page and flush the TLB
+ */
+int32_t user_page_touch_write(uint32_t addr){
+    page_table_entry_t* pte;
+
+    if (user_page_touch(addr)) return -1;
+    if (addr < USRMEM_BOTTOM || addr >= USRMEM_TOP) return 0;
+
+    pte = &user_page_table[pcb_array[(uint8_t)current_pid]->proc->processid][USER_PAGE(addr)];
+    if (pte->AVL & PTE_COW){
+        return user_page_fault(addr, PF_WRITE);
+    }
+    return 0;
+}
+
+
+/* user_range_reserve
+ * 
+ * Reserves free pages for the heap or an anonymous mapping, to be zero
+ * filled on first touch.
+ * Inputs: int32_t pid - process, uint32_t start, end - page aligned range
+ *         uint8_t mmap - nonzero for an anonymous mapping
+ * Outputs: 0, or -1 if some page is in use or in the stack region.
+ * Side Effects: None
+ */
+int32_t user_range_reserve(int32_t pid, uint32_t start, uint32_t end, uint8_t mmap){
+    uint32_t i;
+
+    if (start < USRMEM_BOTTOM || end > USRMEM_BOTTOM + (STACK_PAGE << 12) || start > end) return -1;
+    for (i = USER_PAGE(start); i < USER_PAGE(end); i++){
+        if (user_page_table[pid][i].P || user_page_table[pid][i].AVL) return -1;
+    }
+    for (i = USER_PAGE(start); i < USER_PAGE(end); i++){
+        user_page_table[pid][i].AVL = PTE_LAZY | (mmap ? PTE_MMAP : 0);
+    }
+    return 0;
+}
+
+
+/* user_range_release
+ * 
+ * Gives back heap or mapped pages, moving out anyone who still shares them.
+ * Inputs: int32_t pid - process, uint32_t start, end - page aligned range
+ *         uint8_t mmap - nonzero if the range must all be an anonymous mapping
+ * Outputs: 0, or -1 if mmap is set and some page is not mapped memory.
+ * Side Effects: Flushes the TLB.
+ */
+int32_t user_range_release(int32_t pid, uint32_t start, uint32_t end, uint8_t mmap){
+    uint32_t flags, i;
+
+    if (start < USRMEM_BOTTOM || end > USRMEM_TOP || start > end) return -1;
+    for (i = USER_PAGE(start); mmap && i < USER_PAGE(end); i++){
+        if (!(user_page_table[pid][i].AVL & PTE_MMAP)) return -1;
+    }
+
+    cli_and_save(flags);
+    for (i = USER_PAGE(start); i < USER_PAGE(end); i++){
+        if (user_page_table[pid][i].P && (user_page_table[pid][i].AVL & PTE_COW) &&
+            user_page_table[pid][i].physical_address == USER_FRAME(pid) + i){
+            cow_evict_sharers(pid, i);
+        }
+        user_page_table[pid][i].P = 0;
+        user_page_table[pid][i].AVL = 0;
+    }
+    flush_tlb();
+    restore_flags(flags);
+    return 0;
+}
+
+
+/* user_range_map_file
+ * 
+ * Maps a file read only over a reserved range. A data block that sits on a
+ * page boundary is mapped where it is in the file system image; one that
+ * does not, or the last block whose tail is past the end of the file, is
+ * copied into the process's own frame with the tail zeroed.
+ * Inputs: int32_t pid - process, uint32_t start - page aligned start of a
+ *         range reserved with user_range_reserve
+ *         uint32_t inode - the file, uint32_t offset - page aligned offset in it
+ *         uint32_t pages - size of the mapping
+ * Outputs: 0, or -1 if the file does not have that many pages past offset.
+ * Side Effects: Flushes the TLB.
+ */
+int32_t user_range_map_file(int32_t pid, uint32_t start, uint32_t inode, uint32_t offset, uint32_t pages){
+    uint32_t flags, i, k, size, n;
+    data_block_t* block;
+
+    size = get_file_size(inode);
+    if (size == (uint32_t)-1 || offset >= size || pages > (size - offset + USER_PAGE_SIZE - 1) / USER_PAGE_SIZE) return -1;
+
+    cli_and_save(flags);
+    for (k = 0; k < pages; k++){
+        i = USER_PAGE(start) + k;
+        if (NULL == (block = file_block(inode, offset / USER_PAGE_SIZE + k))){
+            restore_flags(flags);
+            return -1;
+        }
+        n = size - offset - k * USER_PAGE_SIZE;
+        if (n >= USER_PAGE_SIZE && !((uint32_t)block & (USER_PAGE_SIZE - 1))){
+            user_page_table[pid][i].physical_address = (uint32_t)block >> 12;
+        } else{
+            load_phys_page(USER_FRAME(pid) + i, block, n < USER_PAGE_SIZE ? n : USER_PAGE_SIZE);
+            user_page_table[pid][i].physical_address = USER_FRAME(pid) + i;
+        }
+        user_page_table[pid][i].R_W = 0;
+        user_page_table[pid][i].AVL = PTE_MMAP;
+        user_page_table[pid][i].P = 1;
+    }
+    flush_tlb();
+    restore_flags(flags);
+    return 0;
+}
+
+
+/* user_range_find
+ * 
+ * Finds room for an anonymous mapping, searching down from the stack region
+ * so the heap keeps the room above it as long as possible.
+ * Inputs: int32_t pid - process, uint32_t pages - size of the mapping
+ * Outputs: start address of a free run of pages, 0 if there is none.
+ * Side Effects: None
+ */
+uint32_t user_range_find(int32_t pid, uint32_t pages){
+    int32_t i;
+    uint32_t run = 0;
+
+    if (pages == 0) return 0;
+    for (i = STACK_PAGE - 1; i >= 0; i--){
+        if (user_page_table[pid][i].P || user_page_table[pid][i].AVL){
+            run = 0;
+        } else if (++run == pages){
+            return USRMEM_BOTTOM + (i << 12);
+        }
+    }
+    return 0;
+}
+
+
+/* user_pages_release
+ * 
+ * Unmaps a halting process's program memory. Pages of its frame that other
+ * processes still share are copied out to them first, since the frame goes
+ * to whoever gets the pid next.
+ * Inputs: int32_t pid - the halting process
+ * Outputs: None
+ * Side Effects: Flushes the TLB.
+ */
+void user_pages_release(int32_t pid){
+    uint32_t flags;
+    int i;
+
+    cli_and_save(flags);
+    for (i = 0; i < PDM_SIZE; i++){
+        if (!user_page_table[pid][i].P) continue;
+        if ((user_page_table[pid][i].AVL & PTE_COW) && user_page_table[pid][i].physical_address == USER_FRAME(pid) + i){
+            cow_evict_sharers(pid, i);
+        }
+        user_page_table[pid][i].P = 0;
+        user_page_table[pid][i].AVL = 0;
+    }
+    flush_tlb();
+    restore_flags(flags);
+}
+
+
 /* load_program_image
  * 
  * Loads program image data into program memory at a specified offset.
@@ -150,33 +606,45 @@ int32_t load_program_image(uint32_t offset, const uint8_t* buf, uint32_t length)
     return 0; // return success
 }
 
-int32_t map_vidmap_mem(){
-    page_directory[33].page_directory_union.kb.P = 1;
-    page_directory[33].page_directory_union.kb.U_S = 1;
-    page_directory[33].page_directory_union.kb.physical_address = ((uint32_t)vidmap_page_table) >> 12;
+/* map_vidmap_mem
+ * 
+ * Maps term's text memory for programs at VIDMAP_ADDR, through a directory
+ * entry of its own. The kernel's own mapping of text memory in the first
+ * page table is never touched, so its scratch pages stay reachable too.
+ * Inputs: int32_t term - terminal whose text memory to map
+ * Outputs: 0 on success, or -1 for a bad terminal.
+ * Side Effects: Flushes the TLB.
+ */
+int32_t map_vidmap_mem(int32_t term){
+    if (term < 0 || term >= 3) return -1;
 
-    vidmap_page_table[0].P = 1;
-    vidmap_page_table[0].U_S = 1;
-    vidmap_page_table[0].physical_address = 0xB8; //184, physical position of vmem
+    page_directory[VIDMAP_PDE].page_directory_union.kb.physical_address = ((uint32_t)vidmap_page_table) >> 12;
+    page_directory[VIDMAP_PDE].page_directory_union.kb.PS = 0;
+    page_directory[VIDMAP_PDE].page_directory_union.kb.U_S = 1;
+    page_directory[VIDMAP_PDE].page_directory_union.kb.R_W = 1;
+    page_directory[VIDMAP_PDE].page_directory_union.kb.P = 1;
+    vidmap_retarget(term);
 
     flush_tlb();
     return 0;
 }
 
 
-// useless function going to get rid of it later
-int32_t update_video_memory_paging(int8_t target_terminal){
-    if(target_terminal < 0 || target_terminal > 3){
-        return -1;
-    }
-    if(terminal_process_index == target_terminal){
-        // set video memory paging to the regular physical memory of vidoe mem
-        vidmap_page_table[VIDMEM_INDEX].physical_address = VIDMEM_INDEX; //184, physical position of vmem
-    }else{
-        vidmap_page_table[VIDMEM_INDEX].physical_address = TERM1_INDEX + target_terminal; //184, physical position of vmem
-    }
-    return 0;
+/* vidmap_retarget
+ * 
+ * Points the vidmap pages at term's text memory, shown or not it always
+ * lives at the same physical address.
+ * Inputs: int32_t term - terminal of the process about to run
+ * Outputs: None
+ * Side Effects: caller flushes the TLB
+ */
+void vidmap_retarget(int32_t term){
+    int i;
 
+    for (i = 0; i < TERM_VMEM_PAGES; i++){
+        vidmap_page_table[i].physical_address = VIDMEM_INDEX + TERM_VMEM_PAGES * term + i;
+        vidmap_page_table[i].P = 1;
+    }
 }
 
 
@@ -5,7 +5,13 @@
 #include "types.h"
 
 #define VIDMEM_INDEX    0xB8 //index at which to set table to
-#define TERM1_INDEX     0xB9 //index of term1 vidmem
+#define TERM_VMEM_PAGES 2 //4kB pages of VGA text memory per terminal
+#define VIDMAP_PDE      33 //programs see their terminal's text memory at 132MB
+#define VIDMAP_ADDR     (VIDMAP_PDE << 22)
+#define USER_IMAGE_ADDR 0x08048000 //programs are copied in here
+#define USER_PAGE_SIZE  0x1000
+#define USER_STACK_PAGES 256 //top 1MB of program memory is stack, mapped as it is touched
+#define PF_WRITE        0x2 //page fault error code: caused by a write
 
 extern void load_page_directory(unsigned int* page_directory_addr);
 extern void enable_paging();
@@ -14,8 +20,19 @@ extern void flush_tlb();
 void paging_init();
 int32_t map_program_mem(int32_t pid);
 int32_t load_program_image(uint32_t offset, const uint8_t* buf, uint32_t length);
-int32_t map_vidmap_mem();
-int32_t update_video_memory_paging(int8_t target_terminal);
+int32_t map_vidmap_mem(int32_t term);
+void vidmap_retarget(int32_t term);
+uint32_t user_virt_to_phys(uint32_t addr);
+void user_pages_init(int32_t pid, uint32_t image_end, uint32_t bss_end);
+void user_pages_fork(int32_t parent, int32_t child);
+void user_pages_release(int32_t pid);
+int32_t user_page_fault(uint32_t addr, uint32_t err);
+int32_t user_page_touch(uint32_t addr);
+int32_t user_page_touch_write(uint32_t addr);
+int32_t user_range_reserve(int32_t pid, uint32_t start, uint32_t end, uint8_t mmap);
+int32_t user_range_release(int32_t pid, uint32_t start, uint32_t end, uint8_t mmap);
+uint32_t user_range_find(int32_t pid, uint32_t pages);
+int32_t user_range_map_file(int32_t pid, uint32_t start, uint32_t inode, uint32_t offset, uint32_t pages);
 
 /* Struct for Page Directory Elements */
 typedef struct page_directory_entry_kb {
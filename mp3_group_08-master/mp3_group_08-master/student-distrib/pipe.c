@@ -0,0 +1,208 @@
+#include "pipe.h"
+#include "lib.h"
+#include "system_calls.h"
+
+#define PIPE_MASK (PIPE_SIZE - 1)
+
+static pipe_t pipes[MAX_PIPES];
+
+/* fd_pipe
+ * 
+ * Inputs: fd -- pipe end of the running process
+ * Outputs: the pipe it refers to
+ * Side Effects: None
+ */
+static pipe_t* fd_pipe(int32_t fd){
+    return &pipes[pcb_array[(uint8_t)current_pid]->proc->fdarray[fd].inode_num];
+}
+
+/* pipe_alloc
+ * 
+ * Inputs: None
+ * Outputs: index of a pipe with one read and one write end, -1 if all are in use
+ * Side Effects: None
+ */
+int32_t pipe_alloc(void){
+    uint32_t flags;
+    int32_t i;
+
+    cli_and_save(flags);
+    for(i = 0; i < MAX_PIPES; i++){
+        if(pipes[i].readers == 0 && pipes[i].writers == 0){
+            pipes[i].head = pipes[i].tail = 0;
+            pipes[i].readers = 1;
+            pipes[i].writers = 1;
+            pipes[i].read_wait.waiters = 0;
+            pipes[i].write_wait.waiters = 0;
+            restore_flags(flags);
+            return i;
+        }
+    }
+    restore_flags(flags);
+    return -1;
+}
+
+/* pipe_ref
+ * 
+ * Inputs: idx -- pipe, end -- 0 for the read end, 1 for the write end
+ * Outputs: None
+ * Side Effects: None
+ */
+void pipe_ref(uint32_t idx, uint8_t end){
+    uint32_t flags;
+
+    if(idx >= MAX_PIPES){
+        return;
+    }
+    cli_and_save(flags);
+    if(end){
+        pipes[idx].writers++;
+    } else{
+        pipes[idx].readers++;
+    }
+    restore_flags(flags);
+}
+
+/* pipe_read
+ * 
+ * sleeps until there is data, then copies out as much as is there
+ * Inputs: fd -- read end, buf -- user buffer, nbytes -- its size
+ * Outputs: bytes read, 0 once it is empty with no write end left, -1 on bad input
+ * Side Effects: wakes writers waiting for room
+ */
+int32_t pipe_read(int32_t fd, void* buf, int32_t nbytes){
+    pipe_t* p = fd_pipe(fd);
+    uint32_t flags;
+    int32_t n = 0;
+
+    if(buf == NULL || nbytes < 0){
+        return -1;
+    }
+
+    cli_and_save(flags);
+    while(p->head == p->tail && p->writers > 0){
+        wait_queue_sleep(&p->read_wait);
+    }
+    while(n < nbytes && p->tail != p->head){
+        ((uint8_t*)buf)[n++] = p->buf[p->tail & PIPE_MASK];
+        p->tail++;
+    }
+    wake_up(&p->write_wait);
+    restore_flags(flags);
+    return n;
+}
+
+/* pipe_write
+ * 
+ * copies everything in, sleeping whenever the ring is full. A non-blocking
+ * fd stops at the first full ring instead
+ * Inputs: fd -- write end, buf -- data, nbytes -- its size
+ * Outputs: bytes written, -1 once no read end is left (before anything was written),
+ *          -EAGAIN for a non-blocking fd that could write nothing
+ * Side Effects: wakes readers
+ */
+int32_t pipe_write(int32_t fd, const void* buf, int32_t nbytes){
+    pipe_t* p = fd_pipe(fd);
+    uint8_t nonblock = pcb_array[(uint8_t)current_pid]->proc->fdarray[fd].nonblock;
+    uint32_t flags;
+    int32_t n = 0;
+
+    if(buf == NULL || nbytes < 0){
+        return -1;
+    }
+
+    cli_and_save(flags);
+    while(n < nbytes && p->readers > 0){
+        if(p->head - p->tail == PIPE_SIZE){
+            wake_up(&p->read_wait);
+            if(nonblock){
+                break;
+            }
+            wait_queue_sleep(&p->write_wait);
+            continue;
+        }
+        p->buf[p->head & PIPE_MASK] = ((const uint8_t*)buf)[n++];
+        p->head++;
+    }
+    wake_up(&p->read_wait);
+    restore_flags(flags);
+
+    if(n == 0 && nbytes > 0){
+        return (p->readers == 0) ? -1 : -EAGAIN;
+    }
+    return n;
+}
+
+/* pipe_read_close
+ * 
+ * Inputs: fd -- read end being closed
+ * Outputs: 0
+ * Side Effects: the last reader leaving makes writes fail
+ */
+int32_t pipe_read_close(int32_t fd){
+    pipe_t* p = fd_pipe(fd);
+    uint32_t flags;
+
+    cli_and_save(flags);
+    if(p->readers > 0){
+        p->readers--;
+    }
+    wake_up(&p->write_wait);
+    restore_flags(flags);
+    return 0;
+}
+
+/* pipe_write_close
+ * 
+ * Inputs: fd -- write end being closed
+ * Outputs: 0
+ * Side Effects: the last writer leaving gives readers end of file
+ */
+int32_t pipe_write_close(int32_t fd){
+    pipe_t* p = fd_pipe(fd);
+    uint32_t flags;
+
+    cli_and_save(flags);
+    if(p->writers > 0){
+        p->writers--;
+    }
+    wake_up(&p->read_wait);
+    restore_flags(flags);
+    return 0;
+}
+
+/* pipe_read_poll
+ * 
+ * Inputs: fd -- read end, wait -- nonzero to wait for data
+ * Outputs: POLLIN if there is data or end of file, else 0
+ * Side Effects: call with interrupts off
+ */
+int32_t pipe_read_poll(int32_t fd, int32_t wait){
+    pipe_t* p = fd_pipe(fd);
+
+    if(p->head != p->tail || p->writers == 0){
+        return POLLIN;
+    }
+    if(wait){
+        wait_queue_add(&p->read_wait);
+    }
+    return 0;
+}
+
+/* pipe_write_poll
+ * 
+ * Inputs: fd -- write end, wait -- nonzero to wait for room
+ * Outputs: POLLOUT if there is room or no reader left (the write fails at once), else 0
+ * Side Effects: call with interrupts off
+ */
+int32_t pipe_write_poll(int32_t fd, int32_t wait){
+    pipe_t* p = fd_pipe(fd);
+
+    if(p->head - p->tail < PIPE_SIZE || p->readers == 0){
+        return POLLOUT;
+    }
+    if(wait){
+        wait_queue_add(&p->write_wait);
+    }
+    return 0;
+}
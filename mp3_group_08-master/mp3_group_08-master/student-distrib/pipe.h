@@ -0,0 +1,35 @@
+#ifndef _PIPE_H
+#define _PIPE_H
+
+#include "types.h"
+#include "wait_queue.h"
+
+#define PIPE_SIZE       4096    // one page of buffer per pipe, must be a power of 2
+#define MAX_PIPES       4
+
+/* one pipe, the writers only move head and the readers only move tail */
+typedef struct pipe_t {
+    uint8_t buf[PIPE_SIZE];
+    volatile uint32_t head;     // total bytes ever written
+    volatile uint32_t tail;     // total bytes ever read
+    uint32_t readers;           // open read ends, the pipe is free once both counts are 0
+    uint32_t writers;           // open write ends
+    wait_queue_t read_wait;     // readers waiting for data or the last writer to leave
+    wait_queue_t write_wait;    // writers waiting for room or the last reader to leave
+} pipe_t;
+
+/* claims a free pipe with one reader and one writer, returns its index or -1 */
+int32_t pipe_alloc(void);
+
+/* another fd now refers to an end of pipe idx (0 read, 1 write) */
+void pipe_ref(uint32_t idx, uint8_t end);
+
+/* file operations for the two ends, reached through fops_t only */
+int32_t pipe_read(int32_t fd, void* buf, int32_t nbytes);
+int32_t pipe_write(int32_t fd, const void* buf, int32_t nbytes);
+int32_t pipe_read_close(int32_t fd);
+int32_t pipe_write_close(int32_t fd);
+int32_t pipe_read_poll(int32_t fd, int32_t wait);
+int32_t pipe_write_poll(int32_t fd, int32_t wait);
+
+#endif /* _PIPE_H */
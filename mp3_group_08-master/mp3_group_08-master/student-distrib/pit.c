@@ -4,6 +4,9 @@
 #include "system_calls.h"
 #include "x86_desc.h"
 #include "paging.h"
+#include "klog.h"
+#include "mouse.h"
+#include "wait_queue.h"
 
 #define MAX_PID_FREQ 1193182
 
@@ -13,10 +16,12 @@
 #define CTRL_PORT 0x43
 
 int8_t terminal_process_index = -1; // so terminals yet
+volatile uint32_t pit_ticks = 0;
+wait_queue_t pit_tick_wait;
 
 void pit_init(){
     cli();
-    int divisor = MAX_PID_FREQ/100; //set to 100 Hz
+    int divisor = MAX_PID_FREQ/PIT_HZ; //set to 100 Hz
     outb(LOHIBYTE | MODE_3, CTRL_PORT);
     outb(divisor && 0xFF, CH0_PORT);
     outb(divisor >> 8, CH0_PORT); // left shift 8
@@ -24,38 +29,77 @@ void pit_init(){
     enable_irq(0); // irq0
 }
 
-void pit_handler(){
-    //branching here, 3 options -> execute shell, do nothing (all shells), switch process to another
-    int8_t start_idx = terminal_process_index;
-
-    terminal_process_index = (terminal_process_index + 1) % 3; // calculate the index of the terminal we are running the next process on
+/* next_runnable
+ * 
+ * round robin over the process slots, starting after prev_pid
+ * Inputs: prev_pid -- process that was running, -1 if none
+ * Outputs: pid to run next (prev_pid itself if nothing else can), -1 if none can run
+ * Side Effects: None
+ */
+static int8_t next_runnable(int8_t prev_pid){
+    int8_t i, pid;
+
+    for (i = 1; i <= MAX_PROCESSES; i++) {
+        pid = (prev_pid + i + MAX_PROCESSES) % MAX_PROCESSES;
+        if (pid_runnable(pid)) {
+            return pid;
+        }
+    }
+    return -1;
+}
 
-    while(1) {
-        if (terminal_process_index == start_idx) { //loop and all shells
+void pit_handler(){
+    //branching here, 3 options -> execute shell, do nothing (nothing else can run), switch process to another
+    int8_t prev_pid = current_pid;
+    int8_t next_pid;
+    uint8_t t;
+
+    pit_ticks++;
+    wake_up(&pit_tick_wait); // anything waiting out a timeout checks the time again
+
+    klog_tick(); // the idle loop drains the kernel log once it is behind
+    mouse_bottom_half(); // cursor and paint work queued by the mouse irq
+
+    // a terminal without its shell yet gets one before anything else runs
+    for (t = 0; t < 3; t++) {
+        if (pid_arr[t] == -1) {
+            terminal_process_index = t;
+            schedule(prev_pid, -1);
             send_eoi(0);
             return;
-        } else if (pid_arr[(uint8_t) terminal_process_index] != -1 && shell_mask[(uint8_t) pid_arr[(uint8_t)terminal_process_index]] && cur_terminal != terminal_process_index) {
-            terminal_process_index = (terminal_process_index + 1) % 3; // increment, but ensure 0-3
-            continue;
         }
-        
-        break;
     }
 
-    schedule(start_idx);
+    next_pid = next_runnable(prev_pid);
+    if (next_pid == -1 || next_pid == prev_pid) { // sleeping processes stay put until something wakes
+        send_eoi(0);
+        return;
+    }
+
+    schedule(prev_pid, next_pid);
 
     send_eoi(0);
 }
 
 
-void schedule(int8_t prev_idx) {
+/* schedule
+ * 
+ * switches from one process to another. Processes are scheduled on their own,
+ * so several can share a terminal; terminal_process_index follows the process
+ * Inputs: prev_pid -- process to save, -1 if there is none (idle or halted)
+ *         next_pid -- process to run, -1 to start the shell of terminal_process_index
+ * Outputs: None
+ * Side Effects: returns on next_pid's kernel stack
+ */
+void schedule(int8_t prev_pid, int8_t next_pid) {
     // store esp, ebp, tss
     /* Context Switch (creates own context switch stack and IRET) */
     uint32_t curr_ESP;
     uint32_t curr_EBP;
+    pcb_block_t* curr_pcb;
 
-    if (prev_idx != -1){
-        pcb_block_t* prev_pcb = pcb_array[(uint8_t)pid_arr[(uint8_t)prev_idx]];
+    if (prev_pid != -1){
+        pcb_block_t* prev_pcb = pcb_array[(uint8_t)prev_pid];
         // store esp, ebp, tss
         /* Context Switch (creates own context switch stack and IRET) */
         /* assmebly to store current process's ESP & EBP */
@@ -71,35 +115,60 @@ void schedule(int8_t prev_idx) {
         prev_pcb->TSS_program_ss0 = tss.ss0;
     }
 
-    if (pid_arr[(uint8_t)terminal_process_index] == -1) { // start a shell
+    if (next_pid == -1) { // start a shell
         // execute shell
+        current_pid = -1;
         send_eoi(0);
         execute((uint8_t *)"shell");
-    } else { // context switch to existing program
-        pcb_block_t* curr_pcb = pcb_array[(uint8_t)pid_arr[(uint8_t)terminal_process_index]];
+        return;
+    }
+
+    curr_pcb = pcb_array[(uint8_t)next_pid];
+    current_pid = next_pid;
+    terminal_process_index = curr_pcb->terminal;
 
-        // remapping program image memory
-        map_program_mem(pid_arr[(uint8_t)terminal_process_index]);
+    // remapping program image memory
+    map_program_mem(next_pid);
 
-        tss.esp0 = MB4 - KB4 * pid_arr[(uint8_t)terminal_process_index] - 4;  // -4 for gap in between
-        tss.ss0 = KERNEL_DS;
+    tss.esp0 = MB4 - KB4 * next_pid - 4;  // -4 for gap in between
+    tss.ss0 = KERNEL_DS;
 
+    // a vidmapped program sees the text memory of the terminal it runs on
+    vidmap_retarget(terminal_process_index);
+    flush_tlb();
+
+    if (curr_pcb->state == PROC_NEW) { // spawned or a new thread, there is no kernel stack to go back to
+        curr_pcb->state = PROC_READY;
+        send_eoi(0);
         asm volatile (
-            "movl %0, %%esp       ;"
-            "movl %1, %%ebp       ;"
+            "pushl %1            ;" // Push USER_DS
+            "pushl %3            ;" // Push esp, the top of a program's frame or a thread's own stack
+            "pushfl              ;" // Push flags
+            "orl $0x200, (%%esp) ;" // with interrupts on
+            "pushl %0            ;" // Push USER_CS
+            "pushl %2            ;" // Push entry eip
+            "iret                ;"
             :
-            : "r"(curr_pcb->program_ESP), "r"(curr_pcb->program_EBP)
+            : "r"(USER_CS), "r"(USER_DS), "r"(curr_pcb->prev_EIP), "r"(curr_pcb->user_ESP)
         );
+    }
 
-
-        // change paging of video memory to the target process's terminal buffer in physical memory
-        if(terminal_process_index != cur_terminal){ //if processs is not being displayed
-            vidmap_page_table[VIDMEM_INDEX].physical_address = TERM1_INDEX + terminal_process_index;
-        }else{ //if process is being displayed
-            vidmap_page_table[VIDMEM_INDEX].physical_address = VIDMEM_INDEX;
-        }
-
-        return;
+    if (curr_pcb->state == PROC_FORKED) { // its kernel stack holds only the copied syscall frame
+        curr_pcb->state = PROC_READY;
+        send_eoi(0);
+        asm volatile (
+            "movl %0, %%esp          ;"
+            "xorl %%eax, %%eax       ;" // fork returns 0 in the child
+            "jmp system_call_done    ;"
+            :
+            : "r"(curr_pcb->program_ESP)
+        );
     }
-}
 
+    asm volatile (
+        "movl %0, %%esp       ;"
+        "movl %1, %%ebp       ;"
+        :
+        : "r"(curr_pcb->program_ESP), "r"(curr_pcb->program_EBP)
+    );
+}
@@ -2,12 +2,18 @@
 #define _PIT_H
 
 #include "terminal.h"
+#include "wait_queue.h"
+
+#define PIT_HZ 100 // scheduler ticks per second
 
 extern int8_t pid_arr[3]; // 3 terminals
 extern uint8_t shell_mask[6]; 
 
+extern volatile uint32_t pit_ticks; // ticks since boot
+extern wait_queue_t pit_tick_wait; // woken on every tick, for timeouts
+
 void pit_init();
 void pit_handler();
-void schedule(int8_t prev_idx);
+void schedule(int8_t prev_pid, int8_t next_pid);
 
 #endif
@@ -1,5 +1,25 @@
 #include "rtc.h"
 #include "i8259.h"
+#include "paging.h"
+#include "file_system.h"
+#include "wait_queue.h"
+
+
+static wait_queue_t rtc_wait; // readers waiting for the next tick
+
+/* rtc_fd_entry
+ * 
+ * Inputs: fd -- rtc file descriptor of the running process
+ * Outputs: its fd array entry, NULL outside a process or for a bad fd
+ * Side Effects: None
+ */
+static fda_entry_t* rtc_fd_entry(int32_t fd){
+    pcb_block_t* pcb;
+    if (current_pid < 0 || fd < 0 || fd >= 8) return NULL;
+    pcb = pcb_array[(uint8_t)current_pid];
+    if (pcb == NULL) return NULL;
+    return &pcb->proc->fdarray[fd];
+}
 
 /* rtc_init
  * 
@@ -56,27 +76,56 @@ void rtc_handler(){
     inb(rtc_ioport_2);          //throw away contents
     rtc_counter++;              //increment rtc_counter
     rtc_interrupt = 1;
+    wake_up(&rtc_wait);
     send_eoi(8);                //send eoi on irq port 8 of rtc
 }
 
 
 /* rtc_read
  * 
- * Blocks until the next RTC interrupt occurs.
- * Inputs: uint32_t fd - not used in the function
+ * Blocks until there has been an RTC interrupt since this fd last read. The fd's
+ * file_pos holds the tick count it last saw, so a tick that came in between two
+ * reads (or while poll said the fd was ready) is not missed
+ * Inputs: uint32_t fd - rtc file descriptor, only used inside a process
  *         void* buf - not used in the function
  *         uint32_t nbytes - not used in the function
  * Outputs: 0 on success
- * Side Effects: Waits for an RTC interrupt by checking rtc_interrupt.
+ * Side Effects: sleeps on rtc_wait, other terminals run meanwhile
  */
 int32_t rtc_read(int32_t fd, void* buf, int32_t nbytes){
-    rtc_interrupt = 0; // reset interrupt to 0
-    while(1){
-        if (rtc_interrupt == 1){ // check to see if an interrupt has occured
-            return 0; // return success
-        }
+    fda_entry_t* f = rtc_fd_entry(fd);
+    uint32_t seen, flags;
+
+    cli_and_save(flags);
+    seen = (f != NULL) ? f->file_pos : rtc_counter;
+    while (rtc_counter == seen){ // no tick yet
+        wait_queue_sleep(&rtc_wait);
     }
-    return -1; // return failure
+    if (f != NULL){
+        f->file_pos = rtc_counter;
+    }
+    rtc_interrupt = 0;
+    restore_flags(flags);
+    return 0; // return success
+}
+
+/* rtc_poll
+ * 
+ * Inputs: fd -- rtc file descriptor
+ *         wait -- nonzero to wait on rtc_wait if there has been no tick
+ * Outputs: POLLIN if a read would return right away, else 0
+ * Side Effects: call with interrupts off
+ */
+int32_t rtc_poll(int32_t fd, int32_t wait){
+    fda_entry_t* f = rtc_fd_entry(fd);
+
+    if (f != NULL && rtc_counter != f->file_pos){
+        return POLLIN;
+    }
+    if (wait){
+        wait_queue_add(&rtc_wait);
+    }
+    return 0;
 }
 
 
@@ -121,6 +170,8 @@ int32_t rtc_write(int32_t fd, const void* buf, int32_t nbytes){
  * Side Effects: Sets global variables rtc_frequency and calls rtc_change_rate.
  */
 int32_t rtc_open(const uint8_t* filename){
+    // open() set file_pos to 0, the first read still waits for a fresh tick
+    rtc_counter = 0;
     rtc_frequency = 2;  // sets the rtc_frequency to 2Hz 
     rtc_change_rate(15); // rate is 15 for a frequency of 2Hz
     
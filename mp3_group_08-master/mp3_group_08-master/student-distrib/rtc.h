@@ -26,5 +26,6 @@ extern int32_t rtc_read(int32_t fd, void* buf, int32_t nbytes);
 extern int32_t rtc_write(int32_t fd, const void* buf, int32_t nbytes);
 extern int32_t rtc_open(const uint8_t* filename);
 extern int32_t rtc_close(int32_t fd);
+extern int32_t rtc_poll(int32_t fd, int32_t wait);
 
 #endif /* _RTC_H */
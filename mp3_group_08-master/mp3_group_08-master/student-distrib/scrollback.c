@@ -0,0 +1,206 @@
+#include "scrollback.h"
+#include "lib.h"
+
+#define SB_BYTE_MASK    (SCROLLBACK_BYTES - 1)
+#define SB_LINE_MASK    (SCROLLBACK_LINES - 1)
+#define SB_MAX_RECORD   (2 + NUM_COLS * 3)  // header, every char, a run per cell
+
+static scrollback_t scrollback[3]; // 3 terminals
+
+/* record_size
+ *
+ * size in bytes of the encoded line starting at pos
+ * Inputs: sb -- history to look in
+ *         pos -- byte position of the line
+ * Outputs: bytes the line takes up
+ * Side Effects: None
+ */
+static uint32_t record_size(scrollback_t* sb, uint32_t pos){
+    return 2 + sb->data[pos & SB_BYTE_MASK] + 2 * sb->data[(pos + 1) & SB_BYTE_MASK];
+}
+
+/* encode_row
+ *
+ * packs a screen row, chars up to the last non-space and attributes as runs
+ * Inputs: row -- NUM_COLS cells
+ *         out -- at least SB_MAX_RECORD bytes
+ * Outputs: bytes written to out
+ * Side Effects: None
+ */
+static uint32_t encode_row(const uint16_t* row, uint8_t* out){
+    uint32_t i, len, nchars = NUM_COLS, nruns = 0;
+
+    while (nchars > 0 && (row[nchars - 1] & 0xFF) == ' ') {
+        nchars--;
+    }
+    for (i = 0; i < nchars; i++) {
+        out[2 + i] = row[i] & 0xFF;
+    }
+    len = 2 + nchars;
+    for (i = 0; i < NUM_COLS; i++) {
+        if (nruns > 0 && out[len - 1] == (row[i] >> 8)) {
+            out[len - 2]++;
+        } else {
+            out[len] = 1;
+            out[len + 1] = row[i] >> 8;
+            len += 2;
+            nruns++;
+        }
+    }
+    out[0] = nchars;
+    out[1] = nruns;
+    return len;
+}
+
+/* decode_row
+ *
+ * expands the line at pos back into NUM_COLS cells
+ * Inputs: sb -- history to read
+ *         pos -- byte position of the line
+ *         row -- NUM_COLS cells to fill
+ * Outputs: None
+ * Side Effects: None
+ */
+static void decode_row(scrollback_t* sb, uint32_t pos, uint16_t* row){
+    uint32_t nchars = sb->data[pos & SB_BYTE_MASK];
+    uint32_t nruns = sb->data[(pos + 1) & SB_BYTE_MASK];
+    uint32_t runs = pos + 2 + nchars;
+    uint32_t i, j, col = 0;
+
+    for (i = 0; i < nruns; i++) {
+        uint32_t run_len = sb->data[(runs + 2 * i) & SB_BYTE_MASK];
+        uint16_t attrib = sb->data[(runs + 2 * i + 1) & SB_BYTE_MASK] << 8;
+        for (j = 0; j < run_len && col < NUM_COLS; j++, col++) {
+            uint8_t c = (col < nchars) ? sb->data[(pos + 2 + col) & SB_BYTE_MASK] : ' ';
+            row[col] = attrib | c;
+        }
+    }
+}
+
+/* render
+ *
+ * draws term's scrolled view into the spare text page and shows it, only the
+ * NUM_ROWS visible rows are touched
+ * Inputs: term -- terminal being viewed, must be on screen
+ * Outputs: None
+ * Side Effects: points the CRTC at VMEM_SPARE
+ */
+static void render(uint8_t term){
+    scrollback_t* sb = &scrollback[term];
+    uint16_t* spare = (uint16_t*)VMEM_SPARE;
+    uint16_t* live = term_visible(term);
+    uint32_t r;
+
+    for (r = 0; r < NUM_ROWS; r++) {
+        if (r < sb->view) { // still above the live screen
+            scrollback_get_line(term, sb->view - r, spare + r * NUM_COLS);
+        } else {
+            memcpy(spare + r * NUM_COLS, live + (r - sb->view) * NUM_COLS, NUM_COLS * 2); //2 bytes per cell
+        }
+    }
+    crtc_set_start(spare);
+}
+
+/* scrollback_push
+ *
+ * appends a row to term's history, dropping the oldest lines when the line
+ * index or the byte ring is full. Callers hold interrupts off.
+ * Inputs: term -- terminal the row belongs to
+ *         row -- NUM_COLS cells about to scroll off the top
+ * Outputs: None
+ * Side Effects: snaps a scrolled back view to the live screen
+ */
+void scrollback_push(uint8_t term, const uint16_t* row){
+    scrollback_t* sb = &scrollback[term];
+    uint8_t record[SB_MAX_RECORD];
+    uint32_t i, len;
+
+    len = encode_row(row, record);
+    while (sb->count == SCROLLBACK_LINES || (sb->head - sb->tail) + len > SCROLLBACK_BYTES) {
+        sb->tail += record_size(sb, sb->tail);
+        sb->first++;
+        sb->count--;
+    }
+    sb->line_pos[(sb->first + sb->count) & SB_LINE_MASK] = sb->head & SB_BYTE_MASK;
+    for (i = 0; i < len; i++) {
+        sb->data[(sb->head + i) & SB_BYTE_MASK] = record[i];
+    }
+    sb->head += len;
+    sb->count++;
+
+    // new output brings the view back down, like any other console
+    if (sb->view) {
+        scrollback_reset(term);
+    }
+}
+
+/* scrollback_get_line
+ *
+ * decodes a line of history
+ * Inputs: term -- terminal to read
+ *         back -- how far above the screen, 1 is the line that scrolled off last
+ *         row -- NUM_COLS cells to fill
+ * Outputs: 0 on success, -1 if there is no such line
+ * Side Effects: None
+ */
+int32_t scrollback_get_line(uint8_t term, uint32_t back, uint16_t* row){
+    scrollback_t* sb;
+    if (term > 2 || row == NULL) return -1;
+    sb = &scrollback[term];
+    if (back == 0 || back > sb->count) return -1;
+
+    decode_row(sb, sb->line_pos[(sb->first + sb->count - back) & SB_LINE_MASK], row);
+    return 0;
+}
+
+/* scrollback_scroll
+ *
+ * moves the view and redraws it, going back to 0 shows the live screen again
+ * Inputs: term -- terminal on screen
+ *         lines -- lines to go back, negative to go forward
+ * Outputs: new number of lines scrolled back, -1 on a bad terminal
+ * Side Effects: reprograms the CRTC start address
+ */
+int32_t scrollback_scroll(uint8_t term, int32_t lines){
+    scrollback_t* sb;
+    int32_t view;
+    if (term > 2) return -1;
+    sb = &scrollback[term];
+
+    view = (int32_t)sb->view + lines;
+    if (view > (int32_t)sb->count) view = sb->count;
+    if (view < 0) view = 0;
+    if (view == 0) {
+        scrollback_reset(term);
+        return 0;
+    }
+    sb->view = view;
+    render(term);
+    return view;
+}
+
+/* scrollback_reset
+ *
+ * leaves the scrolled back view
+ * Inputs: term -- terminal
+ * Outputs: None
+ * Side Effects: shows term's live screen if it is the one displayed
+ */
+void scrollback_reset(uint8_t term){
+    if (term > 2 || scrollback[term].view == 0) return;
+    scrollback[term].view = 0;
+    if (term == cur_terminal) {
+        console_show(term);
+    }
+}
+
+/* scrollback_viewing
+ *
+ * Inputs: term -- terminal
+ * Outputs: nonzero while term shows history instead of its live screen
+ * Side Effects: None
+ */
+uint32_t scrollback_viewing(uint8_t term){
+    if (term > 2) return 0;
+    return scrollback[term].view;
+}
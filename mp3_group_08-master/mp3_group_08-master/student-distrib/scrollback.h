@@ -0,0 +1,38 @@
+#ifndef _SCROLLBACK_H
+#define _SCROLLBACK_H
+
+#include "types.h"
+
+#define SCROLLBACK_LINES    256     // most lines kept per terminal, must be a power of 2
+#define SCROLLBACK_BYTES    16384   // encoded bytes kept per terminal, must be a power of 2
+#define SCROLLBACK_PAGE     24      // lines moved by one Shift+PgUp/PgDn
+
+/* one terminal's history, lines are stored back to back in data as
+ * [number of chars][number of attribute runs][chars][(run length, attrib) pairs]
+ * with trailing spaces dropped, line_pos holds where each line starts */
+typedef struct scrollback_t {
+    uint8_t data[SCROLLBACK_BYTES];
+    uint16_t line_pos[SCROLLBACK_LINES];
+    uint32_t head;      // total bytes ever written
+    uint32_t tail;      // byte position of the oldest line
+    uint32_t first;     // number of the oldest line
+    uint32_t count;     // lines held
+    uint32_t view;      // lines scrolled back, 0 is the live screen
+} scrollback_t;
+
+/* saves a row that is about to scroll off the top of term's screen */
+void scrollback_push(uint8_t term, const uint16_t* row);
+
+/* decodes the line back lines above the screen (1 is the newest) into row */
+int32_t scrollback_get_line(uint8_t term, uint32_t back, uint16_t* row);
+
+/* moves term's view lines further back (negative goes forward) and redraws it */
+int32_t scrollback_scroll(uint8_t term, int32_t lines);
+
+/* returns term to the live screen */
+void scrollback_reset(uint8_t term);
+
+/* nonzero while term is showing history */
+uint32_t scrollback_viewing(uint8_t term);
+
+#endif /* _SCROLLBACK_H */
@@ -0,0 +1,344 @@
+#include "serial.h"
+#include "lib.h"
+#include "i8259.h"
+#include "wait_queue.h"
+#include "system_calls.h"
+
+#define TX_MASK (SERIAL_TX_SIZE - 1)
+#define RX_MASK (SERIAL_RX_SIZE - 1)
+
+static uint8_t tx_ring[SERIAL_TX_SIZE];
+static uint8_t rx_ring[SERIAL_RX_SIZE];
+static volatile uint32_t tx_head, tx_tail;  // producer writes head, irq consumes tail
+static volatile uint32_t rx_head, rx_tail;  // irq writes head, reader consumes tail
+static wait_queue_t rx_wait;                // readers waiting for input
+static wait_queue_t tx_wait;                // writers waiting for room in the tx ring
+static uint32_t tx_dropped;
+static uint8_t tx_irq_on;                   // THRE interrupt currently enabled
+static uint8_t serial_present;
+
+/* tx_start
+ * 
+ * turns on the THRE interrupt so the handler starts feeding the fifo. The 16550
+ * raises the interrupt right away if the holding register is already empty.
+ * Must be called with interrupts off.
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: writes IER
+ */
+static void tx_start(void){
+    if (!tx_irq_on) {
+        tx_irq_on = 1;
+        outb(IER_RX_AVAIL | IER_TX_EMPTY, COM1_PORT + UART_IER);
+    }
+}
+
+/* tx_fill
+ * 
+ * moves up to one fifo worth of bytes from the tx ring into the uart,
+ * and turns the THRE interrupt off once the ring is empty.
+ * Must be called with interrupts off.
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: writes THR / IER, advances tx_tail, wakes writers
+ */
+static void tx_fill(void){
+    int32_t n;
+    for (n = 0; n < UART_FIFO_DEPTH && tx_tail != tx_head; n++) {
+        outb(tx_ring[tx_tail & TX_MASK], COM1_PORT + UART_DATA);
+        tx_tail++;
+    }
+    if (n > 0) {
+        wake_up(&tx_wait);
+    }
+    if (tx_tail == tx_head && tx_irq_on) {
+        tx_irq_on = 0;
+        outb(IER_RX_AVAIL, COM1_PORT + UART_IER);
+    }
+}
+
+/* serial_init
+ * 
+ * programs COM1 for 115200 8N1, enables and clears the fifos and turns on rx interrupts
+ * Inputs: None
+ * Outputs: 0 on success, -1 if no uart is present
+ * Side Effects: enables irq 4
+ */
+int32_t serial_init(void){
+    outb(0x00, COM1_PORT + UART_IER);                  // no interrupts while programming
+    outb(LCR_DLAB, COM1_PORT + UART_LCR);
+    outb(UART_DIVISOR & 0xFF, COM1_PORT + UART_DATA);
+    outb(UART_DIVISOR >> 8, COM1_PORT + UART_IER);
+    outb(LCR_8N1, COM1_PORT + UART_LCR);
+    outb(FCR_ENABLE_14, COM1_PORT + UART_FCR);
+
+    // loopback self test, a missing port reads back 0xFF
+    outb(MCR_LOOPBACK, COM1_PORT + UART_MCR);
+    outb(0xAE, COM1_PORT + UART_DATA);
+    if (inb(COM1_PORT + UART_DATA) != 0xAE) {
+        serial_present = 0;
+        return -1;
+    }
+
+    outb(MCR_DTR_RTS_OUT2, COM1_PORT + UART_MCR);
+    tx_head = tx_tail = 0;
+    rx_head = rx_tail = 0;
+    tx_irq_on = 0;
+    serial_present = 1;
+    outb(IER_RX_AVAIL, COM1_PORT + UART_IER);
+    enable_irq(SERIAL_IRQ);
+    return 0;
+}
+
+/* serial_handler
+ * 
+ * services every pending uart interrupt: rx bytes go into the rx ring (dropped when full),
+ * an empty transmitter gets refilled from the tx ring
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: sends eoi on irq 4
+ */
+void serial_handler(void){
+    uint8_t iir;
+
+    while (!((iir = inb(COM1_PORT + UART_IIR)) & IIR_NO_INT)) {
+        switch ((iir >> 1) & 0x7) {
+            case 0x3:   // line status, reading LSR clears it
+                inb(COM1_PORT + UART_LSR);
+                break;
+            case 0x2:   // rx data available
+            case 0x6:   // rx fifo timeout
+                while (inb(COM1_PORT + UART_LSR) & LSR_DATA_READY) {
+                    uint8_t c = inb(COM1_PORT + UART_DATA);
+                    if (rx_head - rx_tail < SERIAL_RX_SIZE) {
+                        rx_ring[rx_head & RX_MASK] = c;
+                        rx_head++;
+                    }
+                }
+                wake_up(&rx_wait);
+                break;
+            case 0x1:   // transmit holding register empty
+                tx_fill();
+                break;
+            default:    // modem status, reading MSR clears it
+                inb(COM1_PORT + UART_MSR);
+                break;
+        }
+    }
+    send_eoi(SERIAL_IRQ);
+}
+
+/* tx_push
+ * 
+ * appends one byte (CR LF for a newline) to the tx ring and kicks the transmitter
+ * Inputs: c -- byte to send
+ * Outputs: 0 on success, -1 if the ring has no room
+ * Side Effects: may enable the THRE interrupt
+ */
+static int32_t tx_push(uint8_t c){
+    uint32_t flags;
+    uint32_t need = (c == '\n') ? 2 : 1;
+
+    cli_and_save(flags);
+    if (SERIAL_TX_SIZE - (tx_head - tx_tail) < need) {
+        restore_flags(flags);
+        return -1;
+    }
+    if (c == '\n') {
+        tx_ring[tx_head & TX_MASK] = '\r';
+        tx_head++;
+    }
+    tx_ring[tx_head & TX_MASK] = c;
+    tx_head++;
+    tx_start();
+    restore_flags(flags);
+    return 0;
+}
+
+/* serial_putc
+ * 
+ * queues one byte without ever waiting, so it is safe from interrupt context and
+ * for kernel logging
+ * Inputs: c -- byte to send
+ * Outputs: 0 on success, -1 if the byte was dropped
+ * Side Effects: None
+ */
+int32_t serial_putc(uint8_t c){
+    if (!serial_present) return -1;
+
+    if (tx_push(c) == -1) {
+        tx_dropped++;
+        return -1;
+    }
+    return 0;
+}
+
+/* serial_puts
+ * 
+ * queues a NUL terminated string without waiting
+ * Inputs: s -- string to send
+ * Outputs: number of bytes queued
+ * Side Effects: None
+ */
+int32_t serial_puts(const int8_t* s){
+    int32_t i;
+    if (s == NULL) return 0;
+    for (i = 0; s[i] != '\0'; i++) {
+        if (serial_putc(s[i]) == -1) break;
+    }
+    return i;
+}
+
+/* serial_drain_polled
+ * 
+ * pushes the whole tx ring out by polling LSR, for when the irq will never run
+ * again (a fatal exception). Must be called with interrupts off.
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: writes THR, empties the tx ring
+ */
+void serial_drain_polled(void){
+    if (!serial_present) return;
+
+    while (tx_tail != tx_head) {
+        while (!(inb(COM1_PORT + UART_LSR) & LSR_THR_EMPTY));
+        outb(tx_ring[tx_tail & TX_MASK], COM1_PORT + UART_DATA);
+        tx_tail++;
+    }
+}
+
+/* serial_dropped
+ * 
+ * returns how many bytes serial_putc had to throw away
+ * Inputs: None
+ * Outputs: drop count
+ * Side Effects: None
+ */
+uint32_t serial_dropped(void){
+    return tx_dropped;
+}
+
+
+// SERIAL TERMINAL DEVICE
+
+/* serial_open
+ * 
+ * opens the serial terminal device
+ * Inputs: filename -- not used
+ * Outputs: 0 on success, -1 if there is no uart
+ * Side Effects: None
+ */
+int32_t serial_open(const uint8_t* filename){
+    return serial_present ? 0 : -1;
+}
+
+/* serial_close
+ * 
+ * closes the serial terminal device
+ * Inputs: fd -- not used
+ * Outputs: 0
+ * Side Effects: None
+ */
+int32_t serial_close(int32_t fd){
+    return 0;
+}
+
+/* serial_read
+ * 
+ * reads one line from the serial port, echoing and handling backspace the way
+ * terminal_read does. Returns once a CR/LF arrives or the buffer is full.
+ * Inputs: fd -- not used
+ *         buf -- user buffer
+ *         nbytes -- size of buf
+ * Outputs: number of bytes read (including the trailing newline), -1 on bad input
+ * Side Effects: consumes the rx ring, echoes to the tx ring
+ */
+int32_t serial_read(int32_t fd, void* buf, int32_t nbytes){
+    int32_t i = 0;
+    uint32_t flags;
+    uint8_t c;
+    uint8_t* out = (uint8_t*)buf;
+
+    if (buf == NULL || nbytes <= 0) return -1;
+
+    while (i < nbytes) {
+        cli_and_save(flags);
+        while (rx_tail == rx_head) { // nothing yet, sleep until the irq brings some
+            wait_queue_sleep(&rx_wait);
+        }
+        restore_flags(flags);
+        c = rx_ring[rx_tail & RX_MASK];
+        rx_tail++;
+
+        if (c == '\r' || c == '\n') {
+            serial_putc('\n');
+            out[i++] = '\n';
+            break;
+        }
+        if (c == 0x08 || c == 0x7F) { // backspace / delete
+            if (i > 0) {
+                i--;
+                serial_puts("\b \b");
+            }
+            continue;
+        }
+        serial_putc(c);
+        out[i++] = c;
+    }
+    return i;
+}
+
+/* serial_poll
+ * 
+ * serial_read returns at the end of a line, so it is ready once one has come in
+ * Inputs: fd -- not used
+ *         wait -- nonzero to wait on both rings
+ * Outputs: POLLIN and/or POLLOUT
+ * Side Effects: call with interrupts off
+ */
+int32_t serial_poll(int32_t fd, int32_t wait){
+    int32_t ready = 0;
+    uint32_t pos;
+
+    for (pos = rx_tail; pos != rx_head; pos++) {
+        if (rx_ring[pos & RX_MASK] == '\r' || rx_ring[pos & RX_MASK] == '\n') {
+            ready |= POLLIN;
+            break;
+        }
+    }
+    if (tx_head - tx_tail < SERIAL_TX_SIZE) {
+        ready |= POLLOUT;
+    }
+    if (wait) {
+        wait_queue_add(&rx_wait);
+        wait_queue_add(&tx_wait);
+    }
+    return ready;
+}
+
+/* serial_write
+ * 
+ * queues nbytes for transmit. Only waits when the tx ring is completely full,
+ * so ordinary output returns as soon as it is copied.
+ * Inputs: fd -- not used
+ *         buf -- data to send
+ *         nbytes -- number of bytes in buf
+ * Outputs: number of bytes written, -1 on bad input
+ * Side Effects: None
+ */
+int32_t serial_write(int32_t fd, const void* buf, int32_t nbytes){
+    int32_t i;
+    uint32_t flags;
+    const uint8_t* in = (const uint8_t*)buf;
+
+    if (buf == NULL || nbytes < 0 || !serial_present) return -1;
+
+    for (i = 0; i < nbytes; i++) {
+        cli_and_save(flags);
+        while (tx_push(in[i]) == -1) { // ring full, let the irq drain it
+            wait_queue_sleep(&tx_wait);
+        }
+        restore_flags(flags);
+    }
+    return i;
+}
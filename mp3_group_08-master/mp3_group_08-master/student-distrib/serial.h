@@ -0,0 +1,61 @@
+#ifndef _SERIAL_H
+#define _SERIAL_H
+
+#include "types.h"
+
+#define COM1_PORT       0x3F8
+#define SERIAL_IRQ      4       // COM1 sits on irq 4
+
+/* 16550 register offsets from the base port */
+#define UART_DATA       0       // RBR on read, THR on write (DLL when DLAB is set)
+#define UART_IER        1       // interrupt enable (DLM when DLAB is set)
+#define UART_IIR        2       // interrupt identification on read
+#define UART_FCR        2       // fifo control on write
+#define UART_LCR        3
+#define UART_MCR        4
+#define UART_LSR        5
+#define UART_MSR        6
+#define UART_SCRATCH    7
+
+#define IER_RX_AVAIL    0x01
+#define IER_TX_EMPTY    0x02
+#define LCR_8N1         0x03
+#define LCR_DLAB        0x80
+#define FCR_ENABLE_14   0xC7    // enable + clear both fifos, rx trigger at 14 bytes
+#define MCR_DTR_RTS_OUT2 0x0B   // OUT2 gates the irq line to the PIC
+#define MCR_LOOPBACK    0x1E
+#define LSR_DATA_READY  0x01
+#define LSR_THR_EMPTY   0x20
+#define IIR_NO_INT      0x01
+#define UART_FIFO_DEPTH 16
+#define UART_DIVISOR    1       // 115200 baud
+
+#define SERIAL_TX_SIZE  4096    // must be a power of 2
+#define SERIAL_RX_SIZE  256     // must be a power of 2
+
+/* sets up COM1 with fifos and rx interrupts, returns -1 if no uart answers */
+int32_t serial_init(void);
+
+/* irq 4 handler, drains the rx fifo and refills the tx fifo */
+void serial_handler(void);
+
+/* queues one byte for transmit without waiting, returns -1 (and drops it) if the tx ring is full */
+int32_t serial_putc(uint8_t c);
+
+/* queues a string for transmit without waiting, returns number of bytes queued */
+int32_t serial_puts(const int8_t* s);
+
+/* busy-waits the tx ring out to the uart, for fatal paths that run with interrupts off */
+void serial_drain_polled(void);
+
+/* bytes dropped by serial_putc because the tx ring was full */
+uint32_t serial_dropped(void);
+
+/* file operations for the "serial" terminal device */
+int32_t serial_open(const uint8_t* filename);
+int32_t serial_close(int32_t fd);
+int32_t serial_read(int32_t fd, void* buf, int32_t nbytes);
+int32_t serial_write(int32_t fd, const void* buf, int32_t nbytes);
+int32_t serial_poll(int32_t fd, int32_t wait);
+
+#endif /* _SERIAL_H */
@@ -0,0 +1,164 @@
+#include "shm.h"
+#include "lib.h"
+#include "paging.h"
+
+static shm_segment_t segments[SHM_MAX_SEGMENTS];
+
+/* shm_get
+ * 
+ * Inputs: name -- nul terminated, at most SHM_NAME_LEN characters
+ *         pid -- process asking, SHM_NO_CREATOR for none
+ * Outputs: id of the segment with that name, a new one if there was none, -1 if all are in use
+ * Side Effects: a new segment belongs to pid until someone attaches it
+ */
+int32_t shm_get(const uint8_t* name, int32_t pid){
+    uint32_t flags;
+    int32_t i, len, free_id = -1;
+
+    if(name == NULL){
+        return -1;
+    }
+    len = strlen((const int8_t*)name);
+    if(len == 0 || len > SHM_NAME_LEN){
+        return -1;
+    }
+
+    cli_and_save(flags);
+    for(i = 0; i < SHM_MAX_SEGMENTS; i++){
+        if(!segments[i].used){
+            if(free_id == -1){
+                free_id = i;
+            }
+        } else if(!strncmp((const int8_t*)segments[i].name, (const int8_t*)name, SHM_NAME_LEN + 1)){
+            restore_flags(flags);
+            return i;
+        }
+    }
+    if(free_id != -1){
+        strcpy((int8_t*)segments[free_id].name, (const int8_t*)name);
+        segments[free_id].used = 1;
+        segments[free_id].fresh = 1;
+        segments[free_id].attached = 0;
+        segments[free_id].creator = pid;
+    }
+    restore_flags(flags);
+    return free_id;
+}
+
+/* shm_attach
+ * 
+ * Inputs: mask -- attach mask of the running process, id -- segment
+ * Outputs: user address of the segment, 0 if id is not a segment
+ * Side Effects: maps the segment in, zeroing it on its first attach
+ */
+uint32_t shm_attach(uint8_t* mask, int32_t id){
+    uint32_t flags;
+
+    if(mask == NULL || id < 0 || id >= SHM_MAX_SEGMENTS){
+        return 0;
+    }
+
+    cli_and_save(flags);
+    if(!segments[id].used){
+        restore_flags(flags);
+        return 0;
+    }
+    if(!(*mask & (1 << id))){
+        *mask |= 1 << id;
+        segments[id].attached++;
+        segments[id].creator = SHM_NO_CREATOR; // the attach count keeps it now
+        shm_map(*mask);
+    }
+    if(segments[id].fresh){
+        segments[id].fresh = 0;
+        memset((void*)SHM_ADDR(id), 0, SHM_SIZE);
+    }
+    restore_flags(flags);
+    return SHM_ADDR(id);
+}
+
+/* shm_detach
+ * 
+ * Inputs: mask -- attach mask of the process letting go, id -- segment
+ * Outputs: 0, -1 if the process did not have it attached
+ * Side Effects: the last detach frees the segment and its name
+ */
+int32_t shm_detach(uint8_t* mask, int32_t id){
+    uint32_t flags;
+
+    if(mask == NULL || id < 0 || id >= SHM_MAX_SEGMENTS || !(*mask & (1 << id))){
+        return -1;
+    }
+
+    cli_and_save(flags);
+    *mask &= ~(1 << id);
+    if(--segments[id].attached == 0){
+        segments[id].used = 0;
+    }
+    shm_map(*mask);
+    restore_flags(flags);
+    return 0;
+}
+
+/* shm_exit
+ * 
+ * a segment only named by shmget has no attach to free it, so its creator
+ * frees it on the way out
+ * Inputs: pid -- process halting
+ * Outputs: None
+ * Side Effects: frees the segments pid created that were never attached
+ */
+void shm_exit(int32_t pid){
+    uint32_t flags;
+    int32_t i;
+
+    if(pid == SHM_NO_CREATOR){
+        return;
+    }
+
+    cli_and_save(flags);
+    for(i = 0; i < SHM_MAX_SEGMENTS; i++){
+        if(segments[i].used && segments[i].attached == 0 && segments[i].creator == pid){
+            segments[i].used = 0;
+        }
+    }
+    restore_flags(flags);
+}
+
+/* shm_fork
+ * 
+ * Inputs: mask -- segments the parent has attached, the child's mask becomes the same
+ * Outputs: None
+ * Side Effects: None
+ */
+void shm_fork(uint8_t mask){
+    uint32_t flags;
+    int32_t i;
+
+    cli_and_save(flags);
+    for(i = 0; i < SHM_MAX_SEGMENTS; i++){
+        if(mask & (1 << i)){
+            segments[i].attached++;
+        }
+    }
+    restore_flags(flags);
+}
+
+/* shm_map
+ * 
+ * called on every switch of user address space, like map_program_mem
+ * Inputs: mask -- segments the incoming process has attached
+ * Outputs: None
+ * Side Effects: the caller flushes the tlb
+ */
+void shm_map(uint8_t mask){
+    int32_t i;
+
+    for(i = 0; i < SHM_MAX_SEGMENTS; i++){
+        page_directory[SHM_PDE_BASE + i].page_directory_union.mb.physical_address = SHM_FRAME_BASE + i;
+        page_directory[SHM_PDE_BASE + i].page_directory_union.mb.U_S = 1;
+        page_directory[SHM_PDE_BASE + i].page_directory_union.mb.R_W = 1;
+        page_directory[SHM_PDE_BASE + i].page_directory_union.mb.P = (mask >> i) & 1;
+    }
+    flush_tlb();
+}
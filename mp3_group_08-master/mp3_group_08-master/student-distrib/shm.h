@@ -0,0 +1,41 @@
+#ifndef _SHM_H
+#define _SHM_H
+
+#include "types.h"
+
+#define SHM_MAX_SEGMENTS    4
+#define SHM_NAME_LEN        32          // same limit as a file name
+#define SHM_SIZE            0x400000    // each segment is one 4MB page
+#define SHM_PDE_BASE        34          // segment i is at virtual 136MB + 4MB*i, above the vidmap table at 33
+#define SHM_FRAME_BASE      8           // and in physical 4MB frame 8 + i, past the six program frames
+#define SHM_ADDR(id)        ((SHM_PDE_BASE + (id)) << 22)
+#define SHM_NO_CREATOR      -1          // creator of a segment made outside any process, or attached since
+
+/* a named segment, alive while it has a name */
+typedef struct shm_segment_t {
+    uint8_t name[SHM_NAME_LEN + 1];
+    uint8_t used;
+    uint8_t fresh;                      // not zeroed yet, the first attach clears it
+    uint32_t attached;                  // processes that have it mapped
+    int32_t creator;                    // pid that named it, holds it until the first attach
+} shm_segment_t;
+
+/* finds the segment called name, creating it for pid if needed, returns its id or -1 */
+int32_t shm_get(const uint8_t* name, int32_t pid);
+
+/* adds segment id to the attach mask of the running process and maps it, returns its address or 0 */
+uint32_t shm_attach(uint8_t* mask, int32_t id);
+
+/* removes segment id from mask, freeing the segment once nobody has it, returns -1 if it was not attached */
+int32_t shm_detach(uint8_t* mask, int32_t id);
+
+/* frees the segments pid created that nobody ever attached */
+void shm_exit(int32_t pid);
+
+/* a forked child gets the segments in mask too */
+void shm_fork(uint8_t mask);
+
+/* loads the page directory entries for the segments in mask */
+void shm_map(uint8_t mask);
+
+#endif /* _SHM_H */
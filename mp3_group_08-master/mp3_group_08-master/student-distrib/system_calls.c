@@ -5,6 +5,15 @@
 #include "paging.h"
 #include "terminal.h"
 #include "x86_desc.h"
+#include "serial.h"
+#include "klog.h"
+#include "irq_stats.h"
+#include "input.h"
+#include "line_discipline.h"
+#include "pit.h"
+#include "pipe.h"
+#include "shm.h"
+#include "futex.h"
 
 /* Global variables for FDA */
 const static uint8_t ELF_MAGIC[4] = {ELF_0, ELF_1, ELF_2, ELF_3};
@@ -19,13 +28,16 @@ uint8_t shell_mask[6] = {0, 0, 0, 0, 0, 0};
 uint8_t typing_mask[3] = {1, 1, 1};
 static uint8_t pid_mask[6] = {0, 0, 0, 0, 0, 0};
 int8_t pid_arr[3] = {-1, -1, -1}; //circular linked list
+int8_t current_pid = -1; // process on the cpu, -1 while idle
 
 // fops pointer associated with 4 main system calls for RTC
 fops_t rtc_fops = {
     rtc_read,
     rtc_write,
     rtc_open,
-    rtc_close
+    rtc_close,
+    NULL,
+    rtc_poll
 };
 
 // fops pointer associated with 4 main system calls for file system
@@ -49,7 +61,9 @@ fops_t read_fops = {
     terminal_read,
     NULL,
     NULL,
-    NULL
+    NULL,
+    terminal_ioctl,
+    terminal_poll
 };
 
 // fops pointer associated keyboard write
@@ -57,12 +71,97 @@ fops_t write_fops = {
     NULL,
     terminal_write,
     NULL,
-    NULL
+    NULL,
+    terminal_ioctl
+};
+
+// fops pointer associated with 4 main system calls for the serial terminal
+fops_t serial_fops = {
+    serial_read,
+    serial_write,
+    serial_open,
+    serial_close,
+    NULL,
+    serial_poll
+};
+
+// fops pointer associated with 4 main system calls for the kernel log
+fops_t kmsg_fops = {
+    kmsg_read,
+    kmsg_write,
+    kmsg_open,
+    kmsg_close
+};
+
+// fops pointer associated with 4 main system calls for the interrupt handler timings
+fops_t irq_stats_fops = {
+    irq_stats_read,
+    irq_stats_write,
+    irq_stats_open,
+    irq_stats_close
+};
+
+// fops pointer associated with 4 main system calls for keyboard events
+fops_t kbd_dev_fops = {
+    kbd_dev_read,
+    kbd_dev_write,
+    kbd_dev_open,
+    kbd_dev_close,
+    NULL,
+    kbd_dev_poll
+};
+
+// fops pointer associated with 4 main system calls for mouse events
+fops_t mouse_dev_fops = {
+    mouse_dev_read,
+    mouse_dev_write,
+    mouse_dev_open,
+    mouse_dev_close,
+    NULL,
+    mouse_dev_poll
 };
 
+// fops pointer for the read end of a pipe
+fops_t pipe_read_fops = {
+    pipe_read,
+    NULL,
+    NULL,
+    pipe_read_close,
+    NULL,
+    pipe_read_poll
+};
+
+// fops pointer for the write end of a pipe
+fops_t pipe_write_fops = {
+    NULL,
+    pipe_write,
+    NULL,
+    pipe_write_close,
+    NULL,
+    pipe_write_poll
+};
+
+// devices provided by the kernel instead of the file system image
+static device_entry_t device_table[] = {
+    {"serial", &serial_fops},
+    {"kmsg", &kmsg_fops},
+    {"irqstats", &irq_stats_fops},
+    {"keyboard", &kbd_dev_fops},
+    {"mouse", &mouse_dev_fops},
+};
+
+#define NUM_DEVICES (sizeof(device_table) / sizeof(device_table[0]))
+
 /* local functions */
 int32_t copy_program_image(uint32_t inode);
+uint32_t program_end(uint32_t inode, uint32_t image_end);
 int32_t create_pcb(int32_t next_pid);
+fops_t* find_device(const uint8_t* filename);
+int32_t fd_ready(fda_entry_t* fda, int32_t fd, int32_t event);
+void fd_release(pcb_block_t* pcb, int32_t fd);
+void proc_release(pcb_block_t* pcb);
+void orphan_children(int32_t pid);
+int32_t fd_dup(fda_entry_t* fda);
 // int32_t user1_signal_handler();
 // int32_t alarm_signal_handler();
 // int32_t interrupt_signal_handler();
@@ -77,10 +176,7 @@ int32_t create_pcb(int32_t next_pid);
  * Side Effects: Restores parent data, closes file descriptors, updates TSS, and jumps to execute return.
  */
 int32_t halt (uint8_t status){
-    int i; // for loops
-
-    //varun: do i need to check -1 cases???
-    int32_t curr_pid = pid_arr[(uint8_t)terminal_process_index];
+    int32_t curr_pid = current_pid;
 
     pcb_block_t* curr_pcb = pcb_array[curr_pid]; // sets up pcb for specific function
     // could be here
@@ -101,6 +197,33 @@ int32_t halt (uint8_t status){
         );
     }
 
+    if (curr_pcb->spawned || curr_pcb->proc != curr_pcb) {
+        // nobody is blocked in execute for this one, release it and give the cpu away for good.
+        // A thread ends alone, the memory and fds stay with its process
+        cli();
+        orphan_children(curr_pid);
+        if (curr_pcb->proc == curr_pcb) {
+            shell_mask[curr_pid] = 0;
+            proc_release(curr_pcb);
+        }
+        if (curr_pcb->spawned && !curr_pcb->orphan) {
+            // keep the pid until the parent collects the status with wait
+            curr_pcb->exit_status = status;
+            curr_pcb->state = PROC_ZOMBIE;
+            wake_up(&pcb_array[curr_pcb->parentid]->child_wait);
+        } else {
+            pid_mask[curr_pid] = 0;
+        }
+        current_pid = -1; // the next pit tick switches away without saving this stack
+        while (1) {
+            asm volatile ("sti; hlt");
+        }
+    }
+
+    // resets all flags, stdin & stdout too since they may be pipe ends, and lets go of shared memory and threads
+    orphan_children(curr_pid);
+    proc_release(curr_pcb);
+
     /* Restore parent paging */
     if (-1 == map_program_mem(pid_temp)) {
         halt_value = -1; // return failure
@@ -111,11 +234,6 @@ int32_t halt (uint8_t status){
     if (shell_mask[curr_pid]) {
         shell_mask[curr_pid] = 0; // setting to inactive
     }
-
-    // resets all flags (except stdin & stdout)
-    for (i = 2; i < 8; i++) {
-        close(i);
-    }
  
     /* Write parent process' info back to TSS (esp0) */
     tss.esp0 = curr_pcb->TSS_prev_esp0;
@@ -123,7 +241,11 @@ int32_t halt (uint8_t status){
 
     pid_mask[curr_pid] = 0;
     typing_mask[(uint8_t)terminal_process_index] = 1;
+    vidmap_mask[(uint8_t)terminal_process_index] = 0;
+    ldisc_reset((uint8_t)terminal_process_index); //parent gets canonical mode and no leftover keys
     pid_arr[(uint8_t)terminal_process_index] = pid_temp;
+    pcb_array[pid_temp]->state = PROC_READY;
+    current_pid = pid_temp;
     terminal_t* active_term = &(terminal_struct[cur_terminal]);
     active_term->is_executing = 0;
 
@@ -141,31 +263,31 @@ int32_t halt (uint8_t status){
 };
 
 
-/* execute
+/* load_program
  * 
- * Executes a given command by loading and running an executable program.
+ * Claims a pid, checks the executable and copies it in with its arguments,
+ * the part of starting a program that execute and spawn share.
  * Inputs: const uint8_t* command - the command to execute
- * Outputs: Does not return (jumps to a different part of the code)
- * Side Effects: Loads and runs the specified executable program.
+ *         uint32_t* eip - where to put the program's entry point
+ *         int32_t first_pid - lowest pid the program may get
+ * Outputs: the new pid, or -1 on failure.
+ * Side Effects: Leaves the new program's memory mapped in.
  */
-int32_t execute (const uint8_t* command){
-    cli();
+static int32_t load_program (const uint8_t* command, uint32_t* eip, int32_t first_pid){
     dentry_t entry;
     int32_t parse = 0;
     int32_t fnamend = 0;
     uint8_t c, i;
     uint8_t filename[FILENAME_LEN + 1];
     uint8_t shell_name[] = "shell";
-    uint8_t pingpong_name[] = "pingpong";
-    uint8_t fish_name[] = "fish";
     uint8_t arguments[MAX_ARGS_SIZE]; //arguments field w/ max size that can be written in terminal
     uint8_t argflag = 0;
     uint32_t eip_buf;
     int32_t pid_temp = -1;
     uint8_t shell_flag = 0; //boolean
-    uint8_t typing_flag = 1;
+    uint32_t image_end, bss_end;
 
-    for (i = 0; i < 6; i++) {
+    for (i = first_pid; i < MAX_PROCESSES; i++) {
         if (pid_mask[i] == 0) { //available
             pid_temp = i;
             break;
@@ -204,9 +326,7 @@ int32_t execute (const uint8_t* command){
     // check if shell
     if (0 == strncmp( (int8_t*) filename, (int8_t*) shell_name, 6)) { // 6 is the size of the filename
         shell_flag = 1;
-    } else if (0 == strncmp( (int8_t*) filename, (int8_t*) pingpong_name, 9) || 0 == strncmp( (int8_t*) filename, (int8_t*) fish_name, 5)) {
-        typing_flag = 0;
-    }  
+    }
  
     if (-1 == read_dentry_by_name(filename, &entry)) return -1;
     
@@ -229,12 +349,20 @@ int32_t execute (const uint8_t* command){
 
     /* set up program paging */
 
+    image_end = USER_IMAGE_ADDR + get_file_size(entry.inode_num);
+    bss_end = program_end(entry.inode_num, image_end);
+    if (bss_end > USRMEM_TOP - USER_STACK_PAGES * USER_PAGE_SIZE) return -1; // no room left for its stack
+    user_pages_init(pid_temp, image_end, bss_end); // its own frame, bss and stack filled in as they are touched
+    curr_pcb->heap_start = curr_pcb->heap_end = (bss_end + USER_PAGE_SIZE - 1) & ~(USER_PAGE_SIZE - 1);
     if (-1 == map_program_mem(pid_temp)) return -1; // return failure 
 
     /*User-Level Progam Loader */ 
 
     //copy file data to memory
-    if (-1 == copy_program_image(entry.inode_num)) return -1; // return failure
+    if (-1 == copy_program_image(entry.inode_num)) {
+        map_program_mem(current_pid); // caller's image back
+        return -1; // return failure
+    }
 
 
     //varun: maybe does not copy nul byte? could use strcpy, also might wanna move this after the 
@@ -244,6 +372,44 @@ int32_t execute (const uint8_t* command){
         i++;
     }
 
+    // programs started by another inherit its stdin and stdout, which is how a pipeline is wired up
+    if (pid_temp >= 3 && current_pid >= 0) {
+        for (i = 0; i < 2; i++) {
+            fda_entry_t* parent_fda = &pcb_array[(uint8_t)current_pid]->proc->fdarray[i];
+            if (parent_fda->flags && 0 == fd_dup(parent_fda)) {
+                curr_pcb->fdarray[i] = *parent_fda;
+            }
+        }
+    }
+
+    //update shell vals
+    if (shell_flag) {
+        shell_mask[pid_temp] = 1; // setting to active
+    }
+
+    pid_mask[pid_temp] = 1; // set global pid active
+
+    *eip = eip_buf;
+    return pid_temp;
+}
+
+
+/* execute
+ * 
+ * Executes a given command by loading and running an executable program.
+ * Inputs: const uint8_t* command - the command to execute
+ * Outputs: Does not return (jumps to a different part of the code)
+ * Side Effects: Loads and runs the specified executable program.
+ */
+int32_t execute (const uint8_t* command){
+    cli();
+    uint32_t eip_buf;
+    int32_t pid_temp;
+
+    pid_temp = load_program(command, &eip_buf, 0);
+    if (pid_temp == -1) return -1;
+    pcb_block_t* curr_pcb = pcb_array[pid_temp]; // sets up execute pcb
+
     /* Context Switch (creates own context switch stack and IRET) */
     uint32_t curr_ESP;
     uint32_t curr_EBP;
@@ -268,21 +434,14 @@ int32_t execute (const uint8_t* command){
 
     //save this in case we try to exit shell
     curr_pcb->prev_EIP = eip_buf;
-    
-    //update shell vals
-    if (shell_flag) {
-        shell_mask[pid_temp] = 1; // setting to active
-    }
-
-    typing_mask[cur_terminal] = typing_flag;
-
-    pid_mask[pid_temp] = 1; // set global pid active
 
     if (pid_temp < 3) {
         pid_arr[pid_temp] = pid_temp;
     } else {
-        pid_arr[cur_terminal] = pid_temp;
+        pid_arr[(uint8_t)terminal_process_index] = pid_temp;
+        pcb_array[(uint8_t)current_pid]->state = PROC_WAITING; // its stack is frozen in here until the child halts
     }
+    current_pid = pid_temp;
     terminal_t* active_term = &(terminal_struct[cur_terminal]);
     active_term->is_executing = 1;
 
@@ -304,18 +463,51 @@ int32_t execute (const uint8_t* command){
 };
 
 
+/* spawn
+ * 
+ * Starts a program on the caller's terminal without waiting for it. The child
+ * gets the caller's stdin and stdout and is scheduled on its own from the next
+ * pit tick. Once it halts its pid is held until the caller collects its status
+ * with wait, or freed right away if the caller has halted.
+ * Inputs: const uint8_t* command - the command to run
+ * Outputs: The child's pid, or -1 on failure.
+ * Side Effects: None for the caller.
+ */
+int32_t spawn (const uint8_t* command){
+    uint32_t eip_buf, flags;
+    int32_t pid_temp;
+    pcb_block_t* child_pcb;
+
+    if (current_pid < 0 || command == NULL) return -1;
+
+    cli_and_save(flags);
+    pid_temp = load_program(command, &eip_buf, FIRST_USER_PID);
+    if (pid_temp != -1) {
+        child_pcb = pcb_array[pid_temp];
+        child_pcb->prev_EIP = eip_buf;
+        child_pcb->state = PROC_NEW;
+        child_pcb->spawned = 1;
+        map_program_mem(current_pid); // back to the caller's image
+    }
+    restore_flags(flags);
+
+    return pid_temp;
+}
+
+
 /* read
  * 
  * Reads data from the specified file descriptor.
  * Inputs: int32_t fd - file descriptor index
  *         void* buf - buffer to store the read data
  *         int32_t nbytes - number of bytes to read
- * Outputs: The number of bytes read on success, or -1 on failure.
+ * Outputs: The number of bytes read on success, -EAGAIN if the fd is non-blocking
+ *          and nothing is ready, or -1 on failure.
  * Side Effects: Reads data from the file descriptor and updates the buffer.
  */
 int32_t read (int32_t fd, void* buf, int32_t nbytes){
-    int8_t pid = pid_arr[(uint8_t)terminal_process_index];
-    pcb_block_t* curr_pcb = pcb_array[(uint8_t)pid]; // set up read pcb
+    int8_t pid = current_pid;
+    pcb_block_t* curr_pcb = pcb_array[(uint8_t)pid]->proc; // set up read pcb
     if (curr_pcb == NULL || buf == NULL || nbytes < 0 || fd < 0 || fd > 7) return -1; // return faliure
     fda_entry_t curr_fda = curr_pcb->fdarray[fd]; // set up current read fda
 
@@ -328,6 +520,8 @@ int32_t read (int32_t fd, void* buf, int32_t nbytes){
 
     if(*curr_fops.read_ptr == NULL) return -1;
 
+    if (curr_fda.nonblock && !fd_ready(&curr_fda, fd, POLLIN)) return -EAGAIN;
+
     return (*(curr_fops.read_ptr))(fd, buf, nbytes); // return function to be called
 };
 
@@ -338,12 +532,13 @@ int32_t read (int32_t fd, void* buf, int32_t nbytes){
  * Inputs: int32_t fd - file descriptor index
  *         const void* buf - buffer containing the data to write
  *         int32_t nbytes - number of bytes to write
- * Outputs: The number of bytes written on success, or -1 on failure.
+ * Outputs: The number of bytes written on success, -EAGAIN if the fd is non-blocking
+ *          and the device is full, or -1 on failure.
  * Side Effects: Writes data to the file descriptor based on the provided buffer and updates the file.
  */
 int32_t write (int32_t fd, const void* buf, int32_t nbytes){
-    int8_t pid = pid_arr[(uint8_t)terminal_process_index];
-    pcb_block_t* curr_pcb = pcb_array[(uint8_t)pid]; // set up write pcb
+    int8_t pid = current_pid;
+    pcb_block_t* curr_pcb = pcb_array[(uint8_t)pid]->proc; // set up write pcb
     if (curr_pcb == NULL || buf == NULL || nbytes < 0 || fd < 0 || fd > 7) return -1; // return failure
     fda_entry_t curr_fda = curr_pcb->fdarray[fd]; // set up write FDA
 
@@ -356,10 +551,246 @@ int32_t write (int32_t fd, const void* buf, int32_t nbytes){
 
     if(*curr_fops.write_ptr == NULL) return -1;
 
+    if (curr_fda.nonblock && !fd_ready(&curr_fda, fd, POLLOUT)) return -EAGAIN;
+
     return (*(curr_fops.write_ptr))(fd, buf, nbytes); // return function to be called
 };
 
 
+/* sendfile
+ * 
+ * Writes a file to another fd straight from the file system image, a block
+ * at a time, without copying it through a user buffer.
+ * Inputs: int32_t out_fd - where to write, any fd that can be written
+ *         int32_t in_fd - an open regular file, read from its position
+ *         int32_t count - the most bytes to send
+ * Outputs: Bytes sent, 0 at the end of the file, or -1 (-EAGAIN if out_fd is
+ *          nonblocking and full) if nothing could be sent.
+ * Side Effects: Moves in_fd's position past what was sent.
+ */
+int32_t sendfile (int32_t out_fd, int32_t in_fd, int32_t count){
+    pcb_block_t* curr_pcb;
+    fda_entry_t* in;
+    fda_entry_t* out;
+    data_block_t* block;
+    int32_t size, sent = 0, n, ret;
+
+    if (current_pid < 0 || count < 0 || out_fd < 0 || out_fd > 7 || in_fd < 0 || in_fd > 7) return -1;
+    curr_pcb = pcb_array[(uint8_t)current_pid]->proc;
+    in = &curr_pcb->fdarray[in_fd];
+    out = &curr_pcb->fdarray[out_fd];
+    if (!in->flags || in->fops_ptr != &file_fops || !out->flags || out->fops_ptr->write_ptr == NULL) return -1;
+    if (-1 == (size = get_file_size(in->inode_num))) return -1;
+
+    while (sent < count && in->file_pos < size) {
+        if (NULL == (block = file_block(in->inode_num, in->file_pos / BLOCK_BYTE_SIZE))) break;
+        n = BLOCK_BYTE_SIZE - in->file_pos % BLOCK_BYTE_SIZE; // the rest of this block
+        if (n > size - in->file_pos) n = size - in->file_pos;
+        if (n > count - sent) n = count - sent;
+
+        if (out->nonblock && !fd_ready(out, out_fd, POLLOUT)) {
+            return sent ? sent : -EAGAIN;
+        }
+        ret = (*out->fops_ptr->write_ptr)(out_fd, block->byte + in->file_pos % BLOCK_BYTE_SIZE, n);
+        if (ret < 0) return sent ? sent : ret;
+        in->file_pos += ret;
+        sent += ret;
+        if (ret < n) break; // the other end took less, let the caller retry
+    }
+    return sent;
+}
+
+/* seekable_fd
+ * 
+ * Inputs: int32_t fd - fd of the running process
+ * Outputs: its fd array entry if it is an open regular file, the only kind
+ *          with a position to move, else NULL
+ * Side Effects: None
+ */
+static fda_entry_t* seekable_fd (int32_t fd){
+    fda_entry_t* fda;
+
+    if (current_pid < 0 || fd < 0 || fd > 7) return NULL;
+    fda = &pcb_array[(uint8_t)current_pid]->proc->fdarray[fd];
+    if (!fda->flags || fda->fops_ptr != &file_fops) return NULL;
+    return fda;
+}
+
+
+/* lseek
+ * 
+ * Moves the position of a regular file. It may go past the end, reads
+ * there return 0.
+ * Inputs: int32_t fd - an open regular file
+ *         int32_t offset - bytes to move by
+ *         int32_t whence - SEEK_SET, SEEK_CUR or SEEK_END, what offset is from
+ * Outputs: The new position, or -1 if fd cannot seek or the position would
+ *          be negative.
+ * Side Effects: None
+ */
+int32_t lseek (int32_t fd, int32_t offset, int32_t whence){
+    fda_entry_t* fda = seekable_fd(fd);
+    int32_t base;
+
+    if (fda == NULL) return -1;
+    switch (whence) {
+        case SEEK_SET: base = 0; break;
+        case SEEK_CUR: base = fda->file_pos; break;
+        case SEEK_END: base = get_file_size(fda->inode_num); break;
+        default: return -1;
+    }
+    if (base < 0 || (offset < 0 && base + offset < 0) || (offset > 0 && base + offset < base)) return -1;
+
+    fda->file_pos = base + offset;
+    return fda->file_pos;
+}
+
+
+/* pread
+ * 
+ * Reads a regular file at a given offset without using or moving its position.
+ * Inputs: int32_t fd - an open regular file
+ *         void* buf - where to put the bytes, int32_t nbytes - how many
+ *         uint32_t offset - where in the file to start
+ * Outputs: Bytes read, 0 at or past the end of the file, -1 on failure or
+ *          if buf is not all in program memory.
+ * Side Effects: None
+ */
+int32_t pread (int32_t fd, void* buf, int32_t nbytes, uint32_t offset){
+    fda_entry_t* fda = seekable_fd(fd);
+
+    if (fda == NULL || buf == NULL || nbytes < 0) return -1;
+    if ((uint32_t)buf < USRMEM_BOTTOM || (uint32_t)nbytes > USRMEM_TOP - (uint32_t)buf) return -1;
+    return read_data(fda->inode_num, offset, buf, nbytes);
+}
+
+
+/* pwrite
+ * 
+ * Writes a regular file at a given offset without using or moving its
+ * position. The file system is read only, so like write on a file it only
+ * checks its arguments and fails.
+ * Inputs: int32_t fd - an open regular file
+ *         const void* buf - bytes to write, int32_t nbytes - how many
+ *         uint32_t offset - where in the file to start
+ * Outputs: -1
+ * Side Effects: None
+ */
+int32_t pwrite (int32_t fd, const void* buf, int32_t nbytes, uint32_t offset){
+    fda_entry_t* fda = seekable_fd(fd);
+
+    if (fda == NULL || buf == NULL || nbytes < 0) return -1;
+    if ((uint32_t)buf < USRMEM_BOTTOM || (uint32_t)nbytes > USRMEM_TOP - (uint32_t)buf) return -1;
+    return file_write(fd, buf, nbytes);
+}
+
+/* fill_stat
+ * 
+ * Inputs: uint32_t type - STAT_ type of the entry, uint32_t inode - its inode
+ *         stat_t* buf - what to fill in
+ * Outputs: None
+ * Side Effects: None
+ */
+static void fill_stat (uint32_t type, uint32_t inode, stat_t* buf){
+    buf->type = type;
+    buf->inode = inode;
+    buf->size = (type == STAT_FILE) ? get_file_size(inode) : 0;
+    buf->blocks = (buf->size + BLOCK_BYTE_SIZE - 1) / BLOCK_BYTE_SIZE;
+}
+
+
+/* stat_name
+ * 
+ * Describes a file, directory or device by name, for the kernel's own buffers.
+ * Inputs: const uint8_t* filename - the file, directory or device
+ *         stat_t* buf - filled in with its size, type, inode and block count
+ * Outputs: 0 on success, or -1 if there is no such name.
+ * Side Effects: None
+ */
+int32_t stat_name (const uint8_t* filename, stat_t* buf){
+    dentry_t entry;
+
+    if (filename == NULL || buf == NULL) return -1;
+
+    // kernel devices shadow anything with the same name in the file system, as in open
+    if (find_device(filename) != NULL) {
+        fill_stat(STAT_DEV, 0, buf);
+    } else if (0 == read_dentry_by_name(filename, &entry)) {
+        fill_stat(entry.filetype, entry.inode_num, buf);
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+
+/* stat
+ * 
+ * Looks up a file by name without opening it.
+ * Inputs: const uint8_t* filename - the file, directory or device
+ *         stat_t* buf - filled in with its size, type, inode and block count
+ * Outputs: 0 on success, or -1 if there is no such name or either pointer
+ *          is not in program memory.
+ * Side Effects: None
+ */
+int32_t stat (const uint8_t* filename, stat_t* buf){
+    if (filename == NULL || (uint32_t)filename < USRMEM_BOTTOM || (uint32_t)filename >= USRMEM_TOP) return -1;
+    if (buf == NULL || (uint32_t)buf < USRMEM_BOTTOM || (uint32_t)(buf + 1) > USRMEM_TOP) return -1;
+
+    return stat_name(filename, buf);
+}
+
+
+/* fstat
+ * 
+ * Describes an open fd, so a program can size its buffer before reading a file.
+ * Inputs: int32_t fd - an open fd
+ *         stat_t* buf - filled in with its size, type, inode and block count
+ * Outputs: 0 on success, or -1 if fd is not open or buf is not in program memory.
+ * Side Effects: None
+ */
+int32_t fstat (int32_t fd, stat_t* buf){
+    fda_entry_t* fda;
+
+    if (current_pid < 0 || fd < 0 || fd > 7 || buf == NULL) return -1;
+    if ((uint32_t)buf < USRMEM_BOTTOM || (uint32_t)(buf + 1) > USRMEM_TOP) return -1;
+    fda = &pcb_array[(uint8_t)current_pid]->proc->fdarray[fd];
+    if (!fda->flags) return -1;
+
+    if (fda->fops_ptr == &file_fops) {
+        fill_stat(STAT_FILE, fda->inode_num, buf);
+    } else if (fda->fops_ptr == &dir_fops) {
+        fill_stat(STAT_DIR, fda->inode_num, buf);
+    } else if (fda->fops_ptr == &rtc_fops) {
+        fill_stat(STAT_RTC, fda->inode_num, buf);
+    } else {
+        fill_stat(STAT_DEV, 0, buf);
+    }
+    return 0;
+}
+
+/* getdents
+ * 
+ * Lists a directory in bulk: as many entries as fit in buf, each with its
+ * name, type, inode and size.
+ * Inputs: int32_t fd - an open directory
+ *         dirent_t* buf - entries to fill in, int32_t nbytes - size of buf
+ * Outputs: Bytes filled in, 0 at the end of the directory, or -1 if fd is
+ *          not a directory, buf is not all in program memory or cannot hold
+ *          one entry.
+ * Side Effects: Moves the directory's position past the entries read.
+ */
+int32_t getdents (int32_t fd, dirent_t* buf, int32_t nbytes){
+    fda_entry_t* fda;
+
+    if (current_pid < 0 || fd < 0 || fd > 7) return -1;
+    fda = &pcb_array[(uint8_t)current_pid]->proc->fdarray[fd];
+    if (!fda->flags || fda->fops_ptr != &dir_fops) return -1;
+    if (buf == NULL || nbytes < 0 || (uint32_t)buf < USRMEM_BOTTOM || (uint32_t)nbytes > USRMEM_TOP - (uint32_t)buf) return -1;
+
+    return directory_getdents(fd, buf, nbytes);
+}
+
 /* open
  * 
  * Opens a file or device by setting up a file descriptor for it.
@@ -368,12 +799,13 @@ int32_t write (int32_t fd, const void* buf, int32_t nbytes){
  * Side Effects: Sets up a file descriptor for the opened file or device.
  */
 int32_t open (const uint8_t* filename){
-    int8_t pid = pid_arr[(uint8_t)terminal_process_index];
+    int8_t pid = current_pid;
     int32_t fd;
     dentry_t entry;
+    fops_t* device_fops;
     int32_t set = 0; // initialize set
 
-    pcb_block_t* curr_pcb = pcb_array[(uint8_t)pid]; // set up open pcb
+    pcb_block_t* curr_pcb = pcb_array[(uint8_t)pid]->proc; // set up open pcb
     if (curr_pcb == NULL) return -1; // return failure
 
     // set FDA flags
@@ -384,16 +816,28 @@ int32_t open (const uint8_t* filename){
         }
     }
 
-    // check filename
-    if (!set || (-1 == read_dentry_by_name(filename, &entry))) return -1;
+    if (!set || filename == NULL) return -1;
+
+    // kernel devices shadow anything with the same name in the file system
+    device_fops = find_device(filename);
+    if (device_fops != NULL) {
+        entry.filetype = -1;
+        entry.inode_num = 0;
+    } else if (-1 == read_dentry_by_name(filename, &entry)) { // check filename
+        return -1;
+    }
 
     // set up pcb fdarray values
     curr_pcb->fdarray[fd].file_pos = 0;
     curr_pcb->fdarray[fd].flags = 1;
+    curr_pcb->fdarray[fd].nonblock = 0;
     curr_pcb->fdarray[fd].inode_num = entry.inode_num;
 
     // set fops for each type of open call
     switch(entry.filetype) {
+        case -1:            // kernel device
+            curr_pcb->fdarray[fd].fops_ptr = device_fops;
+            break;
         case 0:             // RTC
             curr_pcb->fdarray[fd].fops_ptr = &rtc_fops;
             break;
@@ -426,9 +870,9 @@ int32_t close (int32_t fd){
     if (fd < 2 || fd > 7){
         return -1; // return failure
     }
-    int8_t pid = pid_arr[(uint8_t)terminal_process_index];
+    int8_t pid = current_pid;
     // sets flags to 0 to show it is inactive
-    pcb_block_t* curr_pcb = pcb_array[(uint8_t)pid]; // set up close pcb
+    pcb_block_t* curr_pcb = pcb_array[(uint8_t)pid]->proc; // set up close pcb
     if (curr_pcb == NULL) return -1; // returns failure
     fda_entry_t curr_fda = curr_pcb->fdarray[fd];
     if(curr_fda.flags == 0){
@@ -436,6 +880,8 @@ int32_t close (int32_t fd){
     }
     curr_pcb->fdarray[fd].flags = 0;
     fops_t curr_fops = *(curr_fda.fops_ptr);
+
+    if (curr_fops.close_ptr == NULL) return 0;
     
     // calls the specificed close function which returns -1 or 0 based on success
     return (*(curr_fops.close_ptr))(fd);
@@ -452,8 +898,8 @@ int32_t close (int32_t fd){
  */
 int32_t getargs (uint8_t* buf, int32_t nbytes){
     int i;
-    int8_t pid = pid_arr[(uint8_t)terminal_process_index];
-    pcb_block_t* curr_pcb = pcb_array[(uint8_t)pid];
+    int8_t pid = current_pid;
+    pcb_block_t* curr_pcb = pcb_array[(uint8_t)pid]->proc;
     
     // check for valid PCB and nbytes
     if(curr_pcb == NULL || curr_pcb->args_array[0] == '\0' || nbytes < 1) return -1; //fail if cannot get pcb
@@ -494,39 +940,14 @@ int32_t vidmap (uint8_t** screen_start){
         return -1; // return failure
     }
 
-    // set up page directory entry for video mem
-    page_directory[0].page_directory_union.kb.P = 1;
-    page_directory[0].page_directory_union.kb.U_S = 1;
-    page_directory[0].page_directory_union.kb.R_W = 1;
-    page_directory[0].page_directory_union.kb.physical_address = ((uint32_t)vidmap_page_table) >> 12;
+    // its own directory entry, the kernel keeps its view of text memory
+    map_vidmap_mem(terminal_process_index);
 
-    // set up page table entry for vid mem
-    vidmap_page_table[VIDMEM_INDEX].P = 1;
-    vidmap_page_table[VIDMEM_INDEX].U_S = 1;
-    vidmap_page_table[VIDMEM_INDEX].R_W = 1;
-    vidmap_page_table[VIDMEM_INDEX].physical_address = VIDMEM_INDEX; //184, physical position of vmem
+    // the program draws at the start of its text memory, so stop hardware scrolling this terminal
+    vidmap_mask[(uint8_t)terminal_process_index] = 1;
+    console_rewrap((uint8_t)terminal_process_index);
 
-    // set up page table entry for term1 mem
-    vidmap_page_table[TERM1_INDEX].P = 1;
-    vidmap_page_table[TERM1_INDEX].U_S = 1;
-    vidmap_page_table[TERM1_INDEX].R_W = 1;
-    vidmap_page_table[TERM1_INDEX].physical_address = TERM1_INDEX; //185, physical position of terminal 1
-
-    // set up page table entry for term2 mem
-    vidmap_page_table[TERM2_INDEX].P = 1;
-    vidmap_page_table[TERM2_INDEX].U_S = 1;
-    vidmap_page_table[TERM2_INDEX].R_W = 1;
-    vidmap_page_table[TERM2_INDEX].physical_address = TERM2_INDEX; //186, physical position of terminal 2
-
-    // set up page table entry for term3 mem
-    vidmap_page_table[TERM3_INDEX].P = 1;
-    vidmap_page_table[TERM3_INDEX].U_S = 1;
-    vidmap_page_table[TERM3_INDEX].R_W = 1;
-    vidmap_page_table[TERM3_INDEX].physical_address = TERM3_INDEX; //187, physical position of terminal 3
-
-    flush_tlb(); // flush tlb to update table changes
-
-    *screen_start = (uint8_t*)VIDMEM_ADDR; // set the screen start to the starting address of vid mem
+    *screen_start = (uint8_t*)VIDMAP_ADDR; // set the screen start to this terminal's text memory
     return 0; // return success
 }
 
@@ -577,6 +998,462 @@ int32_t sigreturn (void){
 }
 
 
+/* ioctl
+ * 
+ * Sends a device specific command to the file descriptor's device.
+ * Inputs: int32_t fd - file descriptor index
+ *         int32_t cmd - device specific command, or F_GETFL/F_SETFL for the fd flags
+ *         int32_t arg - argument for the command
+ * Outputs: Whatever the device returns, or -1 on failure.
+ * Side Effects: Depends on the device.
+ */
+int32_t ioctl (int32_t fd, int32_t cmd, int32_t arg){
+    int8_t pid = current_pid;
+    pcb_block_t* curr_pcb = pcb_array[(uint8_t)pid]->proc; // set up ioctl pcb
+    if (curr_pcb == NULL || fd < 0 || fd > 7) return -1; // return failure
+    fda_entry_t curr_fda = curr_pcb->fdarray[fd]; // set up ioctl fda
+
+    // checks if the fda is active if not returns fail
+    if (curr_fda.flags == 0){
+        return -1; // return failure
+    }
+
+    // fd flags belong to the fd, not the device
+    switch (cmd) {
+        case F_GETFL:
+            return curr_fda.nonblock ? O_NONBLOCK : 0;
+        case F_SETFL:
+            if (arg & ~O_NONBLOCK) return -1;
+            curr_pcb->fdarray[fd].nonblock = (arg & O_NONBLOCK) ? 1 : 0;
+            return 0;
+    }
+
+    if(curr_fda.fops_ptr->ioctl_ptr == NULL) return -1;
+
+    return (*(curr_fda.fops_ptr->ioctl_ptr))(fd, cmd, arg); // return function to be called
+}
+
+
+/* poll
+ * 
+ * waits until at least one of fds is ready for the events it asks for, or the
+ * timeout runs out. Each device's poll_ptr reports what is ready and, on the
+ * pass before sleeping, adds the caller to its wait queue, so a wake up from
+ * any of them reruns the scan. Fds with no poll_ptr (files, directories) never
+ * block and are always ready
+ * Inputs: fds -- array of pollfd_t in user memory
+ *         nfds -- entries in fds, at most POLL_MAX_FDS
+ *         timeout -- milliseconds to wait, 0 to only check, -1 to wait forever
+ * Outputs: number of entries with revents set, 0 on timeout, -1 on bad input
+ * Side Effects: sleeps, rounds the timeout up to whole pit ticks
+ */
+int32_t poll (pollfd_t* fds, int32_t nfds, int32_t timeout){
+    int8_t pid = current_pid;
+    pcb_block_t* curr_pcb = pcb_array[(uint8_t)pid]->proc;
+    fda_entry_t* curr_fda;
+    uint32_t deadline, flags;
+    int32_t i, ready, mask;
+
+    if (curr_pcb == NULL || nfds < 0 || nfds > POLL_MAX_FDS || timeout < -1) return -1;
+    if (nfds > 0 && (fds == NULL || (uint32_t)fds < USRMEM_BOTTOM || (uint32_t)(fds + nfds) > USRMEM_TOP)) return -1;
+
+    deadline = pit_ticks + (timeout + 1000 / PIT_HZ - 1) / (1000 / PIT_HZ);
+
+    cli_and_save(flags);
+    while (1) {
+        ready = 0;
+        for (i = 0; i < nfds; i++) {
+            fds[i].revents = 0;
+            if (fds[i].fd < 0 || fds[i].fd > 7 || !curr_pcb->fdarray[fds[i].fd].flags) {
+                fds[i].revents = POLLNVAL;
+                ready++;
+                continue;
+            }
+            curr_fda = &curr_pcb->fdarray[fds[i].fd];
+            if (curr_fda->fops_ptr->poll_ptr == NULL) {
+                mask = POLLIN | POLLOUT;
+            } else {
+                mask = (*(curr_fda->fops_ptr->poll_ptr))(fds[i].fd, timeout != 0);
+            }
+            fds[i].revents = mask & fds[i].events;
+            if (fds[i].revents) ready++;
+        }
+
+        if (ready || timeout == 0) break;
+        if (timeout > 0) {
+            if ((int32_t)(pit_ticks - deadline) >= 0) break;
+            wait_queue_add(&pit_tick_wait);
+        }
+        wait_queue_block();
+    }
+    restore_flags(flags);
+
+    return ready;
+}
+
+
+/* pipe
+ * 
+ * Creates a pipe, a PIPE_SIZE ring that one end writes and the other reads.
+ * Reads sleep while it is empty and return 0 once every write end is closed,
+ * writes sleep while it is full and fail once every read end is closed.
+ * Inputs: int32_t* fds - user array of two, gets the read end then the write end
+ * Outputs: 0 on success, or -1 on failure.
+ * Side Effects: Uses two fds of the caller.
+ */
+int32_t pipe (int32_t* fds){
+    int8_t pid = current_pid;
+    pcb_block_t* curr_pcb = pcb_array[(uint8_t)pid]->proc;
+    int32_t rd = -1, wr = -1, fd, idx;
+
+    if (curr_pcb == NULL || fds == NULL || (uint32_t)fds < USRMEM_BOTTOM || (uint32_t)(fds + 2) > USRMEM_TOP) return -1;
+
+    for (fd = 2; fd < 8; fd++) {
+        if (!curr_pcb->fdarray[fd].flags) {
+            if (rd == -1) {
+                rd = fd;
+            } else {
+                wr = fd;
+                break;
+            }
+        }
+    }
+    if (wr == -1 || -1 == (idx = pipe_alloc())) return -1;
+
+    curr_pcb->fdarray[rd].fops_ptr = &pipe_read_fops;
+    curr_pcb->fdarray[wr].fops_ptr = &pipe_write_fops;
+    for (fd = 0; fd < 2; fd++) {
+        fda_entry_t* fda = &curr_pcb->fdarray[fd ? wr : rd];
+        fda->inode_num = idx;
+        fda->file_pos = 0;
+        fda->nonblock = 0;
+        fda->flags = 1;
+    }
+
+    fds[0] = rd;
+    fds[1] = wr;
+    return 0;
+}
+
+
+/* dup2
+ * 
+ * Makes new_fd refer to what old_fd does, closing new_fd first if it is open.
+ * This is how the shell points a child's stdin or stdout at a pipe.
+ * Inputs: int32_t old_fd - fd to copy
+ *         int32_t new_fd - fd to replace, 0 and 1 allowed
+ * Outputs: new_fd on success, or -1 on failure.
+ * Side Effects: The two fds share nothing but the device, file_pos is copied.
+ */
+int32_t dup2 (int32_t old_fd, int32_t new_fd){
+    int8_t pid = current_pid;
+    pcb_block_t* curr_pcb = pcb_array[(uint8_t)pid]->proc;
+
+    if (curr_pcb == NULL || old_fd < 0 || old_fd > 7 || new_fd < 0 || new_fd > 7) return -1;
+    if (!curr_pcb->fdarray[old_fd].flags) return -1;
+    if (old_fd == new_fd) return new_fd;
+    if (-1 == fd_dup(&curr_pcb->fdarray[old_fd])) return -1;
+
+    fd_release(curr_pcb, new_fd);
+    curr_pcb->fdarray[new_fd] = curr_pcb->fdarray[old_fd];
+    return new_fd;
+}
+
+
+/* shmget
+ * 
+ * Looks up a shared memory segment by name, creating it if there is none.
+ * Segments are SHM_SIZE bytes, zeroed before anyone first sees them, and
+ * live until the last process attached to one detaches or halts. One that
+ * is never attached goes when the process that created it halts.
+ * Inputs: const uint8_t* name - up to 32 characters, like a file name
+ * Outputs: The segment id, or -1 if the name is bad or all segments are in use.
+ * Side Effects: None
+ */
+int32_t shmget (const uint8_t* name){
+    if (current_pid < 0 || name == NULL || (uint32_t)name < USRMEM_BOTTOM || (uint32_t)name >= USRMEM_TOP) return -1;
+    return shm_get(name, pcb_array[(uint8_t)current_pid]->proc->processid);
+}
+
+
+/* shmat
+ * 
+ * Maps a shared memory segment into the caller. Every process sees a segment
+ * at the same address, so pointers into it can be shared too.
+ * Inputs: int32_t id - segment from shmget
+ *         uint8_t** addr - where to put the segment's address
+ * Outputs: 0 on success, or -1 on failure.
+ * Side Effects: Attaching twice does nothing.
+ */
+int32_t shmat (int32_t id, uint8_t** addr){
+    pcb_block_t* curr_pcb;
+    uint32_t start;
+
+    if (current_pid < 0 || addr == NULL || (uint32_t)addr < USRMEM_BOTTOM || (uint32_t)(addr + 1) > USRMEM_TOP) return -1;
+    curr_pcb = pcb_array[(uint8_t)current_pid]->proc;
+
+    if (0 == (start = shm_attach(&curr_pcb->shm_mask, id))) return -1;
+    *addr = (uint8_t*)start;
+    return 0;
+}
+
+
+/* shmdt
+ * 
+ * Unmaps a shared memory segment from the caller.
+ * Inputs: int32_t id - segment from shmget
+ * Outputs: 0 on success, or -1 if it was not attached.
+ * Side Effects: The last detach frees the segment and its name.
+ */
+int32_t shmdt (int32_t id){
+    if (current_pid < 0) return -1;
+    return shm_detach(&pcb_array[(uint8_t)current_pid]->proc->shm_mask, id);
+}
+
+
+/* thread_create
+ * 
+ * Starts a thread in the caller's process. It gets its own pid, kernel stack
+ * and slot in the scheduler, but runs in the caller's memory with the caller's
+ * fds. It starts at entry(arg) on the stack the caller gives it; entry must
+ * not return, the thread ends with halt, which ends only that thread. Halting
+ * the process itself ends all of its threads.
+ * Inputs: void (*entry)(void*) - where the thread starts
+ *         void* arg - entry's argument
+ *         uint8_t* stack_top - top of a stack in the caller's memory
+ * Outputs: The thread's pid, or -1 on failure.
+ * Side Effects: The thread first runs on a later pit tick.
+ */
+int32_t thread_create (void (*entry)(void*), void* arg, uint8_t* stack_top){
+    pcb_block_t* thread_pcb;
+    uint32_t* sp;
+    uint32_t flags;
+    int32_t pid_temp = -1, i;
+
+    if (current_pid < 0 || entry == NULL) return -1;
+
+    // entry sees arg where a caller would have put it, under a return address it must not use
+    sp = (uint32_t*)((uint32_t)stack_top & ~0x3) - 2;
+    if (!user_virt_to_phys((uint32_t)entry) || user_page_touch((uint32_t)sp) || user_page_touch((uint32_t)(sp + 1))) return -1;
+
+    cli_and_save(flags);
+    for (i = FIRST_USER_PID; i < MAX_PROCESSES; i++) {
+        if (pid_mask[i] == 0) {
+            pid_temp = i;
+            break;
+        }
+    }
+    if (pid_temp == -1 || -1 == create_pcb(pid_temp)) {
+        restore_flags(flags);
+        return -1;
+    }
+
+    thread_pcb = pcb_array[pid_temp];
+    thread_pcb->proc = pcb_array[(uint8_t)current_pid]->proc;
+    thread_pcb->prev_EIP = (uint32_t)entry;
+    thread_pcb->user_ESP = (uint32_t)sp;
+    thread_pcb->state = PROC_NEW;
+    sp[0] = 0;
+    sp[1] = (uint32_t)arg;
+    pid_mask[pid_temp] = 1;
+    restore_flags(flags);
+
+    return pid_temp;
+}
+
+
+/* wait
+ * 
+ * Collects the exit status of a child started with spawn. A halted child
+ * keeps its pid until this is called for it.
+ * Inputs: int32_t pid - child to wait for, -1 for any
+ *         int32_t* status - gets the value the child passed to halt, may be NULL
+ *         int32_t options - WNOHANG to return at once if no child has halted
+ * Outputs: The pid collected, 0 under WNOHANG if none has halted yet, or -1
+ *          if the caller has no such child.
+ * Side Effects: Sleeps until a child halts.
+ */
+int32_t wait (int32_t pid, int32_t* status, int32_t options){
+    pcb_block_t* curr_pcb;
+    uint32_t flags;
+    int32_t i, found, child;
+
+    if (current_pid < 0 || (options & ~WNOHANG)) return -1;
+    if (status != NULL && ((uint32_t)status < USRMEM_BOTTOM || (uint32_t)(status + 1) > USRMEM_TOP)) return -1;
+    curr_pcb = pcb_array[(uint8_t)current_pid];
+
+    cli_and_save(flags);
+    while (1) {
+        found = 0;
+        child = -1;
+        for (i = FIRST_USER_PID; i < MAX_PROCESSES; i++) {
+            if (!pid_mask[i] || !pcb_array[i]->spawned || pcb_array[i]->orphan) continue;
+            if (pcb_array[i]->parentid != (uint32_t)current_pid || (pid != -1 && pid != i)) continue;
+            found = 1;
+            if (pcb_array[i]->state == PROC_ZOMBIE) {
+                child = i;
+                break;
+            }
+        }
+        if (child != -1 || !found || (options & WNOHANG)) break;
+        wait_queue_sleep(&curr_pcb->child_wait);
+    }
+
+    if (child != -1) {
+        if (status != NULL) *status = pcb_array[child]->exit_status;
+        pid_mask[child] = 0;
+    }
+    restore_flags(flags);
+
+    if (child != -1) return child;
+    return found ? 0 : -1;
+}
+
+
+/* fork
+ * 
+ * Makes a copy of the calling process that continues from the same fork call.
+ * Program memory is shared copy-on-write, so the copy costs one page table
+ * plus a page for each page either side writes later. The child gets the
+ * caller's fds (every kind fd_dup knows, devices included), arguments and
+ * shared memory, and is collected with wait like a spawned child. Threads
+ * cannot fork.
+ * Inputs: None
+ * Outputs: The child's pid in the parent, 0 in the child, or -1 on failure.
+ * Side Effects: The child first runs on a later pit tick.
+ */
+int32_t fork (void){
+    pcb_block_t* curr_pcb;
+    pcb_block_t* child_pcb;
+    uint32_t flags;
+    int32_t pid_temp = -1, i;
+
+    if (current_pid < 0) return -1;
+    curr_pcb = pcb_array[(uint8_t)current_pid];
+    if (curr_pcb->proc != curr_pcb) return -1;
+
+    cli_and_save(flags);
+    for (i = FIRST_USER_PID; i < MAX_PROCESSES; i++) {
+        if (pid_mask[i] == 0) {
+            pid_temp = i;
+            break;
+        }
+    }
+    if (pid_temp == -1 || -1 == create_pcb(pid_temp)) {
+        restore_flags(flags);
+        return -1;
+    }
+    child_pcb = pcb_array[pid_temp];
+
+    memcpy(child_pcb->args_array, curr_pcb->args_array, MAX_ARGS_SIZE);
+    for (i = 0; i < 8; i++) {
+        // an fd fd_dup cannot share stays closed, so the child's use of it fails with -1
+        child_pcb->fdarray[i].flags = 0;
+        if (curr_pcb->fdarray[i].flags && 0 == fd_dup(&curr_pcb->fdarray[i])) {
+            child_pcb->fdarray[i] = curr_pcb->fdarray[i];
+        }
+    }
+    child_pcb->shm_mask = curr_pcb->shm_mask;
+    shm_fork(child_pcb->shm_mask);
+    child_pcb->heap_start = curr_pcb->heap_start;
+    child_pcb->heap_end = curr_pcb->heap_end;
+    shell_mask[pid_temp] = shell_mask[(uint8_t)current_pid];
+    user_pages_fork(current_pid, pid_temp);
+
+    // the child's kernel stack starts as a copy of the registers and iret frame the syscall pushed
+    child_pcb->program_ESP = MB4 - KB4 * pid_temp - 4 - SYSCALL_FRAME_SIZE;
+    memcpy((void*)child_pcb->program_ESP, (void*)(MB4 - KB4 * current_pid - 4 - SYSCALL_FRAME_SIZE), SYSCALL_FRAME_SIZE);
+    child_pcb->spawned = 1;
+    child_pcb->state = PROC_FORKED;
+    pid_mask[pid_temp] = 1;
+    restore_flags(flags);
+
+    return pid_temp;
+}
+
+
+/* brk
+ * 
+ * Moves the program break, the end of the heap that starts right after the
+ * program's bss. New heap pages are zero filled when first touched, pages
+ * given back are freed.
+ * Inputs: uint32_t end - new break, 0 to only ask for the current one
+ * Outputs: The break after the call, or -1 if it cannot move there.
+ * Side Effects: None
+ */
+int32_t brk (uint32_t end){
+    pcb_block_t* proc;
+    uint32_t old_top, new_top;
+
+    if (current_pid < 0) return -1;
+    proc = pcb_array[(uint8_t)current_pid]->proc;
+    if (end == 0) return proc->heap_end;
+    if (end < proc->heap_start) return -1;
+
+    old_top = (proc->heap_end + USER_PAGE_SIZE - 1) & ~(USER_PAGE_SIZE - 1);
+    new_top = (end + USER_PAGE_SIZE - 1) & ~(USER_PAGE_SIZE - 1);
+    if (new_top > old_top) {
+        if (-1 == user_range_reserve(proc->processid, old_top, new_top, 0)) return -1;
+    } else if (new_top < old_top) {
+        user_range_release(proc->processid, new_top, old_top, 0);
+    }
+    proc->heap_end = end;
+    return end;
+}
+
+
+/* mmap
+ * 
+ * Maps anonymous memory, or a file read only, anywhere there is room; it
+ * need not be next to the heap. Anonymous pages are zero filled when first
+ * touched. A file is mapped in place from the file system image, so reading
+ * it through the mapping copies nothing.
+ * Inputs: uint32_t length - bytes wanted, rounded up to whole pages
+ *         int32_t fd - an open regular file, or -1 for anonymous memory
+ *         uint32_t offset - page aligned offset in the file
+ * Outputs: Start of the mapping, or -1 if there is no room or the file is
+ *          shorter than offset + length, rounded up to a page.
+ * Side Effects: None
+ */
+int32_t mmap (uint32_t length, int32_t fd, uint32_t offset){
+    pcb_block_t* proc;
+    uint32_t pages, start;
+
+    if (current_pid < 0 || length == 0 || length > USRMEM_TOP - USRMEM_BOTTOM) return -1;
+    proc = pcb_array[(uint8_t)current_pid]->proc;
+    if (fd != -1 && (fd < 0 || fd >= 8 || proc->fdarray[fd].flags == 0 ||
+                     proc->fdarray[fd].fops_ptr != &file_fops || (offset & (USER_PAGE_SIZE - 1)))) return -1;
+
+    pages = (length + USER_PAGE_SIZE - 1) / USER_PAGE_SIZE;
+    if (0 == (start = user_range_find(proc->processid, pages))) return -1;
+    if (-1 == user_range_reserve(proc->processid, start, start + pages * USER_PAGE_SIZE, 1)) return -1;
+    if (fd != -1 && -1 == user_range_map_file(proc->processid, start, proc->fdarray[fd].inode_num, offset, pages)) {
+        user_range_release(proc->processid, start, start + pages * USER_PAGE_SIZE, 1);
+        return -1;
+    }
+    return start;
+}
+
+
+/* munmap
+ * 
+ * Unmaps pages of mappings, whole mappings or parts of them.
+ * Inputs: uint32_t addr - page aligned start
+ *         uint32_t length - bytes, rounded up to whole pages
+ * Outputs: 0 on success, or -1 if part of the range is not mapped memory.
+ * Side Effects: None
+ */
+int32_t munmap (uint32_t addr, uint32_t length){
+    pcb_block_t* proc;
+
+    if (current_pid < 0 || (addr & (USER_PAGE_SIZE - 1)) || length == 0) return -1;
+    if (addr < USRMEM_BOTTOM || length > USRMEM_TOP - addr) return -1;
+    proc = pcb_array[(uint8_t)current_pid]->proc;
+
+    return user_range_release(proc->processid, addr, addr + ((length + USER_PAGE_SIZE - 1) & ~(USER_PAGE_SIZE - 1)), 1);
+}
+
+
 /* create_pcb
  * 
  * Creates a Process Control Block (PCB) for a new process.
@@ -596,8 +1473,17 @@ int32_t create_pcb(int32_t next_pid){
     pcb_block_t* local_pcb = (pcb_block_t*) addr;
     
     // sets up pcb struct
-    local_pcb->parentid = (next_pid < 3) ? next_pid : pid_arr[cur_terminal];
+    local_pcb->parentid = (next_pid < 3) ? next_pid : current_pid;
     local_pcb->processid = next_pid;
+    local_pcb->terminal = terminal_process_index;
+    local_pcb->state = PROC_READY;
+    local_pcb->spawned = 0;
+    local_pcb->shm_mask = 0;
+    local_pcb->proc = local_pcb;
+    local_pcb->user_ESP = USER_STACK;
+    local_pcb->orphan = 0;
+    local_pcb->exit_status = 0;
+    local_pcb->child_wait.waiters = 0;
     local_pcb->TSS_prev_esp0 = 0;
     local_pcb->TSS_prev_ss0 = 0;
     local_pcb->prev_EBP = 0;
@@ -610,6 +1496,7 @@ int32_t create_pcb(int32_t next_pid){
     for(w=0; w < 8; w++){
         if(w < 2){
             local_pcb->fdarray[w].flags = 1;
+            local_pcb->fdarray[w].nonblock = 0;
             local_pcb->fdarray[w].file_pos = 0;
             local_pcb->fdarray[w].inode_num = 0;
         } else{
@@ -624,6 +1511,34 @@ int32_t create_pcb(int32_t next_pid){
 }
 
 
+/* program_end
+ * 
+ * Finds where a program's memory ends from its ELF program headers, which
+ * count the bss the file itself leaves out.
+ * Inputs: uint32_t inode - the executable
+ *         uint32_t image_end - end of the file once it is copied in
+ * Outputs: end of the last loaded segment, image_end if that is further or
+ *          the headers cannot be read.
+ * Side Effects: None
+ */
+uint32_t program_end(uint32_t inode, uint32_t image_end) {
+    uint32_t phoff = 0, end = image_end;
+    uint16_t phentsize = 0, phnum = 0, i;
+    uint32_t phdr[6]; // type, offset, vaddr, paddr, filesz, memsz
+
+    if (4 != read_data(inode, ELF_PHOFF, (uint8_t*)&phoff, 4) ||
+        2 != read_data(inode, ELF_PHENTSIZE, (uint8_t*)&phentsize, 2) ||
+        2 != read_data(inode, ELF_PHNUM, (uint8_t*)&phnum, 2)) return image_end;
+
+    for (i = 0; i < phnum; i++) {
+        if (sizeof(phdr) != read_data(inode, phoff + i * phentsize, (uint8_t*)phdr, sizeof(phdr))) break;
+        if (phdr[0] == PT_LOAD && phdr[2] + phdr[5] > end && phdr[2] + phdr[5] <= USRMEM_TOP) {
+            end = phdr[2] + phdr[5];
+        }
+    }
+    return end;
+}
+
 /* copy_program_image
  * 
  * Copies the program image data from the file system to the program memory.
@@ -645,3 +1560,157 @@ int32_t copy_program_image(uint32_t inode) {
     return 0; // return success
 }
 
+
+/* fd_ready
+ * 
+ * asks the device whether a read or write would go through without sleeping,
+ * this is how every non-blocking fd is honored, including devices added later
+ * Inputs: fda -- the fd's entry, fd -- its index, event -- POLLIN or POLLOUT
+ * Outputs: nonzero if ready, devices without a poll_ptr always are
+ * Side Effects: None
+ */
+int32_t fd_ready(fda_entry_t* fda, int32_t fd, int32_t event) {
+    uint32_t flags;
+    int32_t mask;
+
+    if (fda->fops_ptr->poll_ptr == NULL) return 1;
+
+    cli_and_save(flags);
+    mask = (*(fda->fops_ptr->poll_ptr))(fd, 0);
+    restore_flags(flags);
+    return mask & event;
+}
+
+/* fd_release
+ * 
+ * closes a descriptor of any process, including stdin and stdout
+ * Inputs: pcb -- owner of the fd, fd -- index to close
+ * Outputs: None
+ * Side Effects: calls the device's close, which looks the fd up in the running process
+ */
+void fd_release(pcb_block_t* pcb, int32_t fd) {
+    fda_entry_t* fda = &pcb->fdarray[fd];
+
+    if (!fda->flags) return;
+    fda->flags = 0;
+    if (fda->fops_ptr->close_ptr != NULL) {
+        (*(fda->fops_ptr->close_ptr))(fd);
+    }
+}
+
+/* proc_release
+ * 
+ * gives back everything a halting process holds besides its pid
+ * Inputs: pcb -- the running process
+ * Outputs: None
+ * Side Effects: closes all of its fds, lets go of its memory and ends its threads
+ */
+void proc_release(pcb_block_t* pcb) {
+    int32_t i;
+
+    for (i = 0; i < 8; i++) {
+        fd_release(pcb, i);
+    }
+    for (i = 0; i < SHM_MAX_SEGMENTS; i++) {
+        shm_detach(&pcb->shm_mask, i);
+    }
+    shm_exit(pcb->processid);
+    user_pages_release(pcb->processid);
+
+    // its threads go with it, none of them is on the cpu
+    for (i = FIRST_USER_PID; i < MAX_PROCESSES; i++) {
+        if (pid_mask[i] && pcb_array[i] != pcb && pcb_array[i]->proc == pcb) {
+            orphan_children(i);
+            pid_mask[i] = 0;
+            wait_queue_cancel(i);
+            futex_cancel(i);
+        }
+    }
+}
+
+/* orphan_children
+ * 
+ * called as a process or thread ends, its halted spawned children are freed
+ * and the rest free themselves when they halt
+ * Inputs: pid -- the one ending
+ * Outputs: None
+ * Side Effects: None
+ */
+void orphan_children(int32_t pid) {
+    int32_t i;
+
+    for (i = FIRST_USER_PID; i < MAX_PROCESSES; i++) {
+        if (i == pid || !pid_mask[i] || !pcb_array[i]->spawned || pcb_array[i]->parentid != (uint32_t)pid) continue;
+        if (pcb_array[i]->state == PROC_ZOMBIE) {
+            pid_mask[i] = 0;
+        } else {
+            pcb_array[i]->orphan = 1;
+        }
+    }
+}
+
+/* fd_dup
+ * 
+ * takes another reference on what an fd points at, so a copy of the entry can
+ * be closed separately. Terminal, file and directory fds need nothing, and
+ * neither do rtc, serial and kmsg, which keep no per opener state. The rtc
+ * rate is one global setting however many fds are open. Pipes and irqstats
+ * reports count their users, and the keyboard and mouse count the readers of
+ * the current terminal's queue, which a fork child shares.
+ * Inputs: fda -- the entry about to be copied
+ * Outputs: 0 if it can be copied, -1 for an fd type it does not know
+ * Side Effects: None
+ */
+int32_t fd_dup(fda_entry_t* fda) {
+    if (fda->fops_ptr == &pipe_read_fops) {
+        pipe_ref(fda->inode_num, 0);
+        return 0;
+    }
+    if (fda->fops_ptr == &pipe_write_fops) {
+        pipe_ref(fda->inode_num, 1);
+        return 0;
+    }
+    if (fda->fops_ptr == &kbd_dev_fops || fda->fops_ptr == &mouse_dev_fops) {
+        return (*(fda->fops_ptr->open_ptr))(NULL);
+    }
+    if (fda->fops_ptr == &irq_stats_fops) {
+        irq_stats_ref(fda->inode_num);
+        return 0;
+    }
+    if (fda->fops_ptr == &read_fops || fda->fops_ptr == &write_fops ||
+        fda->fops_ptr == &file_fops || fda->fops_ptr == &dir_fops ||
+        fda->fops_ptr == &rtc_fops || fda->fops_ptr == &serial_fops ||
+        fda->fops_ptr == &kmsg_fops) {
+        return 0;
+    }
+    return -1;
+}
+
+/* pid_runnable
+ * 
+ * Inputs: pid -- process slot
+ * Outputs: nonzero if the scheduler may switch to it
+ * Side Effects: None
+ */
+int32_t pid_runnable(int8_t pid) {
+    if (pid < 0 || pid >= MAX_PROCESSES || !pid_mask[(uint8_t)pid]) return 0;
+    if (pcb_array[(uint8_t)pid]->state == PROC_WAITING || pcb_array[(uint8_t)pid]->state == PROC_ZOMBIE) return 0;
+    return !pid_sleeping(pid);
+}
+
+/* find_device
+ * 
+ * Looks up a kernel provided device by name.
+ * Inputs: const uint8_t* filename - the name passed to open
+ * Outputs: the device's fops, or NULL if no device has that name
+ * Side Effects: None
+ */
+fops_t* find_device(const uint8_t* filename) {
+    uint32_t i;
+    for (i = 0; i < NUM_DEVICES; i++) {
+        if (0 == strncmp((int8_t*)filename, device_table[i].name, FILENAME_LEN)) {
+            return device_table[i].fops;
+        }
+    }
+    return NULL;
+}
@@ -2,6 +2,7 @@
 #define _FDA_H
 
 #include "lib.h"
+#include "wait_queue.h"
 
 #define ELF_HEADER      4
 #define ELF_0           0x7F
@@ -11,13 +12,13 @@
 
 #define EIP_START       24
 #define EIP_HEADER      4
+#define ELF_PHOFF       28      // offset of the program header table
+#define ELF_PHENTSIZE   42      // size of one program header
+#define ELF_PHNUM       44      // number of program headers
+#define PT_LOAD         1       // program header type of a loaded segment
 #define FILE_BUF_SIZE   64
 
-#define VIDMEM_ADDR     0x00B8000 //address of vidmem
 #define VIDMEM_INDEX    0xB8 //index at which to set table to
-#define TERM1_INDEX     0xB9 //index of term1 vidmem
-#define TERM2_INDEX     0xBA //index of term2 vidmem
-#define TERM3_INDEX     0xBB //index of term3 vidmem
 #define USRMEM_TOP      0x8400000 //top of usermem
 #define USRMEM_BOTTOM   0x8000000 //bottom of usermem
 
@@ -25,7 +26,72 @@
 #define KB4     0x2000
 
 #define MAX_ARGS_SIZE   128
+#define USER_STACK      0x83FFFFC   // initial user esp of a program, 132MB - 4
+#define SYSCALL_FRAME_SIZE  44      // 6 registers system_call_linkage saves under the 5 word iret frame
 
+#define MAX_PROCESSES   6
+#define FIRST_USER_PID  3       // 0-2 are the base shells
+
+// process states for the scheduler
+#define PROC_READY      0       // runnable, resumes from its saved kernel stack
+#define PROC_NEW        1       // spawned and never run, first switch irets to its entry
+#define PROC_WAITING    2       // blocked in execute until its child halts
+#define PROC_ZOMBIE     3       // spawned and halted, holds its pid until wait collects its status
+#define PROC_FORKED     4       // forked and never run, first switch returns 0 from its copy of the fork syscall
+
+// wait options
+#define WNOHANG         0x1     // return 0 instead of sleeping when no child has halted yet
+
+// lseek whence
+#define SEEK_SET        0       // offset from the start of the file
+#define SEEK_CUR        1       // offset from the current position
+#define SEEK_END        2       // offset from the end of the file
+
+
+// poll events, a fops poll_ptr returns the ones that would not block right now
+#define POLLIN          0x1     // read would return without sleeping
+#define POLLOUT         0x4     // write would return without sleeping
+#define POLLNVAL        0x20    // fd is not open, always reported
+
+#define POLL_MAX_FDS    8
+
+// fd flags, handled by ioctl itself for every kind of fd
+#define F_GETFL         0x100   // returns the fd's O_ flags
+#define F_SETFL         0x101   // arg is the new O_ flags
+#define O_NONBLOCK      0x1
+
+#define EAGAIN          11      // -EAGAIN: a non-blocking fd has nothing ready
+
+// what stat and fstat fill in
+#define STAT_RTC        0       // the types of file system entries
+#define STAT_DIR        1
+#define STAT_FILE       2
+#define STAT_DEV        3       // a kernel device, terminal or pipe, nothing in the file system
+
+typedef struct stat
+{
+    uint32_t size;          // bytes, 0 for anything but a file
+    uint32_t type;
+    uint32_t inode;
+    uint32_t blocks;        // data blocks the file uses
+} stat_t;
+
+// one directory entry as getdents packs them, as many as fit in the buffer
+typedef struct dirent
+{
+    uint32_t inode;
+    uint32_t size;          // bytes, 0 for anything but a file
+    uint32_t type;          // STAT_RTC, STAT_DIR or STAT_FILE
+    uint8_t name[33];       // FILENAME_LEN characters at most, always 0 terminated
+} dirent_t;
+
+// one fd for poll, the kernel fills in revents
+typedef struct pollfd
+{
+    int32_t fd;
+    int16_t events;
+    int16_t revents;
+} pollfd_t;
 
 // system calls
 int32_t halt(uint8_t status);
@@ -38,6 +104,34 @@ int32_t getargs (uint8_t* buf, int32_t nbytes);
 int32_t vidmap (uint8_t** screen_start);
 int32_t set_handler (int32_t signum, void* handler_address);
 int32_t sigreturn (void);
+int32_t ioctl (int32_t fd, int32_t cmd, int32_t arg);
+int32_t poll (pollfd_t* fds, int32_t nfds, int32_t timeout);
+int32_t pipe (int32_t* fds);
+int32_t dup2 (int32_t old_fd, int32_t new_fd);
+int32_t spawn (const uint8_t* command);
+int32_t shmget (const uint8_t* name);
+int32_t shmat (int32_t id, uint8_t** addr);
+int32_t shmdt (int32_t id);
+int32_t thread_create (void (*entry)(void*), void* arg, uint8_t* stack_top);
+int32_t wait (int32_t pid, int32_t* status, int32_t options);
+int32_t fork (void);
+int32_t brk (uint32_t end);
+int32_t mmap (uint32_t length, int32_t fd, uint32_t offset);
+int32_t munmap (uint32_t addr, uint32_t length);
+int32_t sendfile (int32_t out_fd, int32_t in_fd, int32_t count);
+int32_t lseek (int32_t fd, int32_t offset, int32_t whence);
+int32_t pread (int32_t fd, void* buf, int32_t nbytes, uint32_t offset);
+int32_t pwrite (int32_t fd, const void* buf, int32_t nbytes, uint32_t offset);
+int32_t stat (const uint8_t* filename, stat_t* buf);
+int32_t stat_name (const uint8_t* filename, stat_t* buf);
+int32_t fstat (int32_t fd, stat_t* buf);
+int32_t getdents (int32_t fd, dirent_t* buf, int32_t nbytes);
+
+// sets up the pcb of a new process in slot next_pid
+int32_t create_pcb(int32_t next_pid);
+
+// lets the scheduler pick among live processes
+int32_t pid_runnable(int8_t pid);
 
 // points to individual device system calls
 typedef struct fops
@@ -46,8 +140,17 @@ typedef struct fops
     int32_t (*write_ptr)(int32_t, const void*, int32_t);
     int32_t (*open_ptr)(const uint8_t*);
     int32_t (*close_ptr)(int32_t);
+    int32_t (*ioctl_ptr)(int32_t, int32_t, int32_t);
+    int32_t (*poll_ptr)(int32_t, int32_t);  // ready events, adds the caller to the device's wait queue when asked, NULL if it never blocks
 } fops_t;
 
+// a kernel device that open() finds by name
+typedef struct device_entry
+{
+    const int8_t* name;
+    fops_t* fops;
+} device_entry_t;
+
 // file descriptor array struct
 typedef struct fda_entry
 {
@@ -55,6 +158,7 @@ typedef struct fda_entry
     uint32_t inode_num;
     uint32_t file_pos;
     uint32_t flags : 1; // 1 bit
+    uint32_t nonblock : 1; // O_NONBLOCK, reads and writes that would sleep fail with -EAGAIN
 } fda_entry_t;
 
 // the pcb struct
@@ -75,10 +179,24 @@ typedef struct pcb_block
     uint32_t program_ESP;
     uint32_t program_EBP;
 
+    uint8_t terminal; // terminal the process reads and draws on
+    uint8_t state; // PROC_READY, PROC_NEW or PROC_WAITING
+    uint8_t spawned; // started by spawn, no parent is blocked in execute for it
+    uint8_t shm_mask; // shared memory segments attached, bit i for segment i
+    struct pcb_block* proc; // process whose memory, fds and args this uses, itself unless this is a thread
+    uint32_t user_ESP; // user stack a PROC_NEW starts on
+    uint8_t orphan; // spawned and its parent halted, nobody will wait for it
+    uint8_t exit_status; // what a PROC_ZOMBIE passed to halt
+    wait_queue_t child_wait; // woken when a spawned child halts
+    uint32_t heap_start; // first byte after the program's bss
+    uint32_t heap_end; // the program break, brk moves it
+
 } pcb_block_t;
 
 pcb_block_t* pcb_array[6]; // 6 processes possible
 
+extern int8_t current_pid; // process on the cpu, -1 while idle
+
 extern uint8_t cur_terminal;
 extern int8_t terminal_process_index;
 
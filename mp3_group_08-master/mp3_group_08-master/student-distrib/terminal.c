@@ -1,9 +1,10 @@
 #include "terminal.h"
 #include "lib.h"
 #include "paging.h"
+#include "scrollback.h"
+#include "line_discipline.h"
+#include "system_calls.h"
 
-#define FIRST_VIDMEM_PAGE       185
-#define FOURKB_SIZE             4096
 #define MAX_BUF_SIZE            128
 
 uint8_t cur_terminal = 0;
@@ -21,7 +22,6 @@ int32_t terminal_open(const uint8_t* filename){
     terminal_t* active_term = &(terminal_struct[(uint8_t)terminal_process_index]);
     memset(active_term->keyboard_buf, 0, MAX_BUF_SIZE);
     active_term->keyboard_idx = 0;
-    active_term->enter_flag = 0;
     active_term->cursor_x = 0;
     active_term->cursor_y = 0;
     active_term->is_executing = 0;
@@ -45,65 +45,17 @@ int32_t terminal_close(int32_t fd){
 
 /* terminal_read
  * 
- * copies keyboard buffer into user buffer, returns upon a user pressing enter
- * Inputs: int32 fd, void* buf (user buffer), int32 nbytes (# of bytes to be written)
+ * reads keystrokes for the calling process's terminal through the line
+ * discipline, in canonical mode returns upon a user pressing enter
+ * Inputs: int32 fd, void* buf (user buffer), int32 nbytes (# of bytes to be read)
  * Outputs: number of bytes read
- * Side Effects: None
+ * Side Effects: sleeps until there is input
  */
 int32_t terminal_read(int32_t fd, void* buf, int32_t nbytes){
-    int i;
-    //typing_allowed = 1;
-
     if(buf == NULL){
         return -1;
     }
-
-    terminal_t* active_term = &(terminal_struct[(uint8_t)terminal_process_index]);
-
-    while(!active_term->enter_flag){ //while enter has not been pressed
-        //sti();
-        for(i = 0; i < nbytes; i++){ //iterate over keyboard buffer
-            //active_term->prev_command_buf[i] = active_term->keyboard_buf[i]; 
-            ((char *)buf)[i] = active_term->keyboard_buf[i]; //copy char into user buffer
-            if(active_term->keyboard_buf[i] == 0){ //if null character, no characters left to copy
-                break;         
-            }
-        }
-        //cli();
-    }
-    // if(active_term->enter_flag && active_term->is_executing!=1){
-    //     for( i = 0; i < 128; i++){
-    //         active_term->prev_command_buf[i] = active_term->keyboard_buf[i];
-    //     }
-    // }
-
-    ((char *)buf)[i] = 10; //set last bit equal to newline
-
-    int j, k;
-    //update command_buf
-    if(shell_mask[(uint8_t)pid_arr[(uint8_t)terminal_process_index]]){
-        for(k = 9; k > 1; k--){
-            for(j = 0; j < 128; j++){
-                active_term->command_buf[k][j] = active_term->command_buf[k-1][j];
-            }
-            active_term->command_idx[k] = active_term->command_idx[k-1];
-        }
-
-        for(j = 0; j < 128; j++){
-            active_term->command_buf[1][j] = active_term->keyboard_buf[j];
-            active_term->command_buf[0][j] = NULL;
-        }
-        active_term->command_idx[1] = active_term->keyboard_idx;
-        active_term->command_idx[0] = 0;
-        active_term->command_pos = 0;
-    }
-    //reset keyboard_buffer, index, and enter flag
-    //set all 128 entries of buffer to ascii 0
-    memset(active_term->keyboard_buf, 0, MAX_BUF_SIZE);
-    active_term->keyboard_idx = 0;
-    active_term->enter_flag = 0;
-
-    return i+1;
+    return ldisc_read((uint8_t)terminal_process_index, (uint8_t*)buf, nbytes);
 }
 
 /* terminal_write
@@ -124,18 +76,46 @@ int32_t terminal_write(int32_t fd, const void* buf, int32_t nbytes){
         write_term_idx = terminal_process_index + 1;
     } 
 
-    for(i=0; i < nbytes; i++){ //iterate through user buffer
-        if(((char *)buf)[i] == 0){ //if char is NUL skip
-            continue;
-        }
-            putc(((char *)buf)[i]); //output char to screen
-    }
+    i = putc_span((const uint8_t*)buf, nbytes); //output whole buffer, cursor moves once
     
     write_term_idx = 0;
     sti();
     return i; //# of bytes written
 }
 
+/* terminal_ioctl
+ * 
+ * switches the calling process's terminal between canonical and raw mode
+ * Inputs: fd, cmd (TERM_SETMODE or TERM_GETMODE), arg (mode for TERM_SETMODE)
+ * Outputs: 0 or the mode on success, -1 on a bad command or mode
+ * Side Effects: None
+ */
+int32_t terminal_ioctl(int32_t fd, int32_t cmd, int32_t arg){
+    terminal_t* active_term = &(terminal_struct[(uint8_t)terminal_process_index]);
+    switch(cmd){
+        case TERM_SETMODE:
+            if(arg != TERM_MODE_CANON && arg != TERM_MODE_RAW){
+                return -1;
+            }
+            active_term->mode = arg;
+            return 0;
+        case TERM_GETMODE:
+            return active_term->mode;
+    }
+    return -1;
+}
+
+/* terminal_poll
+ * 
+ * Inputs: fd -- not used
+ *         wait -- nonzero to wait for keys if nothing is ready
+ * Outputs: POLLIN once a read would not sleep, else 0
+ * Side Effects: in canonical mode echoes the keys typed so far
+ */
+int32_t terminal_poll(int32_t fd, int32_t wait){
+    return ldisc_poll((uint8_t)terminal_process_index, wait) ? POLLIN : 0;
+}
+
 /* terminal_init
  * 
  * initializes keyboard, terminal variables and sets cursor
@@ -151,11 +131,9 @@ int32_t terminal_init(){
     for(i = 0; i < 3; i++){
         terminal_t* active_term = &(terminal_struct[(uint8_t)i]);
         memset(active_term->keyboard_buf, 0, MAX_BUF_SIZE);
-        memset(active_term->command_buf, 0, MAX_BUF_SIZE * 10);
-        memset(active_term->command_idx, 0, 40); //40 b/c 10 4 byte ints
+        history_init(&active_term->history);
         active_term->keyboard_idx = 0;
-        active_term->enter_flag = 0;
-        active_term->command_pos = 0;
+        active_term->mode = TERM_MODE_CANON;
         write_term_idx = i+1;
         init_colors();
         clear_screen();
@@ -180,16 +158,8 @@ void clear_screen(){
 }
 
 int32_t switch_terminal(uint32_t keycode){
-    /* WILL NEED TO BE DONE (i think)
-     * switch paging of vmem to corresponding terminal
-     * ^ should just be choose which vmem addr (0xB8, 0xB9, 0xBA) to map to physical 0xB8 
-     * switch screen_struct to terminal 1, 2 or 3
-     * set cursor
-     * done?
-    */
     uint8_t terminal_num = keycode - 0x3B;
     terminal_t* new_terminal_struct;
-    terminal_t* old_terminal_struct;
 
     //get correct new terminal struct
     if(terminal_num > 2){ // ensures only 3 terminals
@@ -197,32 +167,18 @@ int32_t switch_terminal(uint32_t keycode){
     }
     new_terminal_struct = &(terminal_struct[terminal_num]);
 
-    //get correct old terminal struct
+    //make sure the old terminal is valid
     if(cur_terminal > 2){
         return -1;
     } 
-    old_terminal_struct = &(terminal_struct[cur_terminal]);
 
-    //calculate pointers for copying memory
-    int8_t* video_page = (int8_t*)VIDEO;
-    int8_t* old_terminal_page = (int8_t*)((FIRST_VIDMEM_PAGE + cur_terminal) << 12); // right shift 12
-    int8_t* new_terminal_page = (int8_t*)((FIRST_VIDMEM_PAGE + terminal_num) << 12); // right shift 12
-
-    // switch back video memory paging to teh direct physical mapping of video memory
-    vidmap_page_table[VIDMEM_INDEX].physical_address = VIDMEM_INDEX;
-
-    //copy vmem
-    memcpy(old_terminal_page, video_page, FOURKB_SIZE);
-    memcpy(video_page, new_terminal_page, FOURKB_SIZE);
-
-    // if the current scheduled process's terminal is different than the one we switched to,
-    // change the video memory paging to the scheduled process's terminal buffer
-    if(terminal_process_index != terminal_num){
-        vidmap_page_table[VIDMEM_INDEX].physical_address = TERM1_INDEX + terminal_process_index;
-    }
+    //leave the old terminal's scrollback so it comes back live
+    scrollback_reset(cur_terminal);
 
-    //update cur_terminal
+    //update cur_terminal, every terminal has its own text memory so showing
+    //it is just pointing the CRTC at it
     cur_terminal = terminal_num;
+    console_show(terminal_num);
 
     //update cursor
     set_cursor(new_terminal_struct->cursor_x, new_terminal_struct->cursor_y);
@@ -3,10 +3,16 @@
 
 #include "keyboard.h"
 #include "lib.h"
+#include "history.h"
 
 #define buffer_size 128;
 
+/* ioctl commands for the terminal */
+#define TERM_SETMODE    1 //arg is TERM_MODE_CANON or TERM_MODE_RAW
+#define TERM_GETMODE    2 //returns the mode
+
 extern int8_t terminal_process_index;
+extern int8_t current_pid;
 extern uint8_t write_term_idx;
 extern int8_t pid_arr[3];
 extern uint8_t typing_mask[3];
@@ -23,6 +29,12 @@ int32_t terminal_read(int32_t fd, void* buf, int32_t nbytes);
 /* writes string stored in buffer to terminal */
 int32_t terminal_write(int32_t fd, const void* buf, int32_t nbytes);
 
+/* changes or reports the terminal mode */
+int32_t terminal_ioctl(int32_t fd, int32_t cmd, int32_t arg);
+
+/* POLLIN once a read would not sleep */
+int32_t terminal_poll(int32_t fd, int32_t wait);
+
 /* initializes terminal variables and keyboard */
 int32_t terminal_init();
 
@@ -42,12 +54,10 @@ void update_term_struct(uint8_t x, uint8_t y);
 typedef struct terminal_t {
     char keyboard_buf[128]; //buffer to store inputs from keyboard
     uint32_t keyboard_idx; //index to measure how many characters have been written
-    uint8_t enter_flag  : 1; //flag to signal whether enter has been pressed
+    uint8_t mode; //TERM_MODE_CANON or TERM_MODE_RAW
     int32_t cursor_x;
     int32_t cursor_y;
-    char command_buf[10][128];
-    int32_t command_idx[10];
-    int32_t command_pos;
+    history_t history; //commands typed into this terminal, for Up/Down and Ctrl+R
     int32_t is_executing : 1;
 } terminal_t;
 
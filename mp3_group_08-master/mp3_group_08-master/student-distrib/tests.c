@@ -5,6 +5,16 @@
 #include "file_system.h"
 #include "keyboard.h"
 #include "terminal.h"
+#include "irq_stats.h"
+#include "scrollback.h"
+#include "history.h"
+#include "input.h"
+#include "line_discipline.h"
+#include "shm.h"
+#include "paging.h"
+#include "futex.h"
+#include "pipe.h"
+#include "system_calls.h"
 
 #define PASS 1
 #define FAIL 0
@@ -575,6 +585,739 @@ int garbage_terminal_test(){
 /* Checkpoint 4 tests */
 /* Checkpoint 5 tests */
 
+/* Performance tests */
+
+/* tsc_hz
+ * 
+ * Counts TSC cycles across RTC_CALIBRATE_TICKS ticks of the 1024 Hz RTC.
+ * Only calibrates, the RTC is too coarse to time anything short
+ * Inputs: None
+ * Outputs: TSC cycles per second, 0 if the RTC is not ticking
+ * Side Effects: Spins for a quarter second
+ */
+static uint32_t tsc_hz(){
+	volatile unsigned* ticks = &rtc_counter; // bumped by the rtc handler
+	unsigned start;
+	uint64_t t0, t1;
+	uint32_t spins = 0;
+
+	// line up with a tick edge so the window is whole ticks
+	start = *ticks;
+	while (*ticks == start) {
+		if (++spins == 0) return 0;
+	}
+	t0 = rdtsc();
+	start = *ticks;
+	while (*ticks - start < RTC_CALIBRATE_TICKS);
+	t1 = rdtsc();
+	return (uint32_t)(t1 - t0) * (1024 / RTC_CALIBRATE_TICKS);
+}
+
+/* tsc_rate
+ * 
+ * bytes per second over a TSC interval, a 64 by 32 divide without libgcc
+ * Inputs: bytes -- bytes written
+ *         hz -- TSC cycles per second
+ *         cycles -- TSC cycles the writes took
+ * Outputs: bytes per second, 0xFFFFFFFF if that does not fit
+ * Side Effects: None
+ */
+static uint32_t tsc_rate(uint32_t bytes, uint32_t hz, uint64_t cycles){
+	uint64_t n = (uint64_t)bytes * hz;
+	uint32_t q, r;
+
+	// scale both sides down until the divisor fits, divl needs high < divisor
+	while (cycles >> 32) {
+		cycles >>= 1;
+		n >>= 1;
+	}
+	if ((uint32_t)(n >> 32) >= (uint32_t)cycles) return 0xFFFFFFFF;
+	asm ("divl %4"
+		: "=a"(q), "=d"(r)
+		: "a"((uint32_t)n), "d"((uint32_t)(n >> 32)), "rm"((uint32_t)cycles)
+	);
+	return q;
+}
+
+/* Terminal Throughput Test
+ * 
+ * Writes a large file to the screen several times, once one putc per byte
+ * and once through terminal_write's span writer, and reports bytes per
+ * second for each. Timed with the TSC, since terminal_write holds interrupts
+ * off and would stall the RTC count; the RTC only calibrates the TSC first
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: Floods the screen, prints both rates
+ * Coverage: putc, putc_span, terminal_write
+ * Files: lib.c, terminal.c
+ */
+int terminal_throughput_test(){
+	TEST_HEADER;
+	static uint8_t data[THROUGHPUT_BUFSIZE];
+	uint8_t large[] = "verylargetextwithverylongname.txt";
+	dentry_t entry;
+	int32_t size, i, j;
+	uint32_t hz;
+	uint64_t start, putc_cycles, span_cycles;
+
+	if (-1 == read_dentry_by_name(large, &entry)) {
+		return FAIL;
+	}
+	size = read_data(entry.inode_num, 0, data, THROUGHPUT_BUFSIZE);
+	if (size <= 0) {
+		return FAIL;
+	}
+	hz = tsc_hz();
+	if (hz == 0) {
+		printf("rtc is not ticking, cannot calibrate the tsc\n");
+		return FAIL;
+	}
+
+	start = rdtsc();
+	for (j = 0; j < THROUGHPUT_ROUNDS; j++) {
+		for (i = 0; i < size; i++) {
+			if (data[i] != 0) {
+				putc(data[i]);
+			}
+		}
+	}
+	putc_cycles = rdtsc() - start;
+
+	start = rdtsc();
+	for (j = 0; j < THROUGHPUT_ROUNDS; j++) {
+		terminal_write(1, data, size);
+	}
+	span_cycles = rdtsc() - start;
+
+	clear_screen();
+	if (putc_cycles == 0 || span_cycles == 0) {
+		return FAIL;
+	}
+	printf("tsc:            %u Hz\n", hz);
+	printf("putc:           %u bytes/s\n", tsc_rate(size * THROUGHPUT_ROUNDS, hz, putc_cycles));
+	printf("terminal_write: %u bytes/s\n", tsc_rate(size * THROUGHPUT_ROUNDS, hz, span_cycles));
+	return PASS;
+}
+
+/* IRQ Stats Test
+ * 
+ * Clears the IRQ timing tables, waits for a burst of RTC interrupts and
+ * checks that the linkage recorded them
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: Prints the per-IRQ count, worst duration and histogram
+ * Coverage: CREATE_HANDLER timing, irq_stats_record
+ * Files: assembly_linkage.S, irq_stats.c/h
+ */
+int irq_stats_test(){
+	TEST_HEADER;
+	irq_stats_t rtc_stats;
+	unsigned start;
+
+	irq_stats_reset();
+	start = rtc_counter;
+	while (rtc_counter - start < 64);	// 64 ticks of the RTC
+
+	if (irq_stats_get(8, &rtc_stats) == -1 || rtc_stats.count < 64) {	// irq 8 is the rtc
+		return FAIL;
+	}
+	if (rtc_stats.max_cycles == 0) {
+		return FAIL;
+	}
+	irq_stats_dump();
+	return PASS;
+}
+
+/* Scrollback Test
+ * 
+ * Pushes more rows than the history holds into terminal 3's scrollback and
+ * checks the newest ones decode back to the exact cells, then checks the
+ * oldest ones were dropped
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: Fills terminal 3's scrollback with test rows
+ * Coverage: scrollback_push, scrollback_get_line
+ * Files: scrollback.c/h
+ */
+int scrollback_test(){
+	TEST_HEADER;
+	static uint16_t row[NUM_COLS];
+	static uint16_t out[NUM_COLS];
+	uint32_t i, j;
+
+	for (i = 0; i < SCROLLBACK_LINES + 8; i++) {
+		for (j = 0; j < NUM_COLS; j++) {	// text on the left, blank on the right, two colors
+			row[j] = ((j < 40 ? 0x0B : 0x1E) << 8) | (j < (i % NUM_COLS) ? 'a' + (i + j) % 26 : ' ');
+		}
+		scrollback_push(2, row);
+	}
+	// row still holds the last line pushed
+	if (scrollback_get_line(2, 1, out) == -1) {
+		return FAIL;
+	}
+	for (j = 0; j < NUM_COLS; j++) {
+		if (out[j] != row[j]) {
+			return FAIL;
+		}
+	}
+	if (scrollback_get_line(2, SCROLLBACK_LINES + 1, out) != -1) {
+		return FAIL;
+	}
+	return PASS;
+}
+
+/* History Test
+ * 
+ * Adds more commands than the history holds, then checks Up/Down order,
+ * that the typed line comes back, and that reverse search finds the newest
+ * match first and older ones after
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: None
+ * Coverage: history_add, history_prev, history_next, history_search
+ * Files: history.c/h
+ */
+int history_test(){
+	TEST_HEADER;
+	static history_t h;
+	char line[HISTORY_LINE_SIZE];
+	char cmd[] = "cat frame0.txt";
+	uint32_t i;
+
+	history_init(&h);
+	for (i = 0; i < HISTORY_DEPTH + 5; i++) {
+		cmd[9] = '0' + (i % 2);	// alternate frame0.txt and frame1.txt
+		history_add(&h, cmd, 14);
+	}
+	history_add(&h, "ls", 2);
+	if (history_count(&h) != HISTORY_DEPTH) {
+		return FAIL;
+	}
+	if (history_prev(&h, "gr", 2, line) != 2 || strncmp(line, "ls", 3)) {
+		return FAIL;
+	}
+	if (history_prev(&h, "", 0, line) != 14 || line[9] != '0' + ((HISTORY_DEPTH + 4) % 2)) {
+		return FAIL;
+	}
+	history_next(&h, line);
+	if (history_next(&h, line) != 2 || strncmp(line, "gr", 3)) {	// typed line comes back
+		return FAIL;
+	}
+	if (history_search(&h, "frame", 5, 1) != 2 || history_search(&h, "frame", 5, 3) != 3) {
+		return FAIL;
+	}
+	if (history_search(&h, "rtc", 3, 1) != -1) {
+		return FAIL;
+	}
+	return PASS;
+}
+
+/* Keyboard Ring Test
+ * 
+ * Fills terminal 3's keystroke ring past capacity and checks keys come back
+ * out in order and the extra ones were refused
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: Empties terminal 3's pending keystrokes
+ * Coverage: kbd_ring_push, kbd_ring_pop, kbd_ring_flush
+ * Files: keyboard.c/h
+ */
+int kbd_ring_test(){
+	TEST_HEADER;
+	uint16_t key;
+	uint32_t i;
+
+	kbd_ring_flush(2);
+	for (i = 0; i < KBD_RING_SIZE; i++) {
+		if (kbd_ring_push(2, 0x10 + (i % 0x20)) == -1) {
+			return FAIL;
+		}
+	}
+	if (kbd_ring_push(2, 0x1C) != -1) {	// full, must be refused
+		return FAIL;
+	}
+	for (i = 0; i < KBD_RING_SIZE; i++) {
+		if (kbd_ring_pop(2, &key) == -1 || key != 0x10 + (i % 0x20)) {
+			return FAIL;
+		}
+	}
+	if (kbd_ring_pop(2, &key) != -1) {
+		return FAIL;
+	}
+	return PASS;
+}
+
+
+/* Input Device Test
+ * 
+ * Events for a device nobody has open are thrown away without counting as drops
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: None
+ * Coverage: input_report_key, input_report_mouse, input_dropped
+ * Files: input.c/h
+ */
+int input_dev_test(){
+	TEST_HEADER;
+	uint32_t key_drops = input_dropped(2, INPUT_KEY);
+	uint32_t mouse_drops = input_dropped(2, INPUT_MOUSE);
+	uint32_t i;
+
+	if (sizeof(input_event_t) != 16) {	// user programs rely on the layout
+		return FAIL;
+	}
+	for (i = 0; i < 2 * INPUT_QUEUE_SIZE; i++) {
+		input_report_key(2, 0x10, i);
+		input_report_mouse(2, 0, 1, -1, 0, i);
+	}
+	if (input_dropped(2, INPUT_KEY) != key_drops || input_dropped(2, INPUT_MOUSE) != mouse_drops) {
+		return FAIL;
+	}
+	return PASS;
+}
+
+
+/* Poll Readiness Test
+ * 
+ * A terminal in raw mode is readable exactly while keys are queued, and one in
+ * canonical mode only once enter has finished the line
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: echoes "a" on terminal 2
+ * Coverage: ldisc_poll, ldisc_reset
+ * Files: line_discipline.c/h
+ */
+int poll_ready_test(){
+	TEST_HEADER;
+	uint32_t flags;
+	int result = PASS;
+
+	ldisc_reset(2);
+	cli_and_save(flags);
+	terminal_struct[2].mode = TERM_MODE_RAW;
+	if (ldisc_poll(2, 0) != 0) result = FAIL;
+	kbd_ring_push(2, 0x1E);	// a
+	if (ldisc_poll(2, 0) != 1) result = FAIL;
+
+	terminal_struct[2].mode = TERM_MODE_CANON;
+	if (ldisc_poll(2, 0) != 0) result = FAIL;	// "a" typed, no enter yet
+	kbd_ring_push(2, 0x1C);
+	if (ldisc_poll(2, 0) != 1) result = FAIL;
+	restore_flags(flags);
+
+	ldisc_reset(2);
+	return result;
+}
+
+/* Shared memory test
+ * 
+ * Asserts that names find the same segment, that a segment is zeroed and
+ * mapped on attach, and that the last detach frees it, or its creator halting
+ * if it was never attached
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: maps and unmaps segment pages in the page directory
+ * Coverage: shm_get, shm_attach, shm_detach, shm_exit
+ * Files: shm.c/h
+ */
+int shm_test(){
+	TEST_HEADER;
+	uint8_t mask = 0;
+	int32_t a, b;
+	uint8_t* mem;
+	int result = PASS;
+
+	a = shm_get((uint8_t*)"frames", SHM_NO_CREATOR);
+	b = shm_get((uint8_t*)"audio", SHM_NO_CREATOR);
+	if (a == -1 || b == -1 || a == b) result = FAIL;
+	if (shm_get((uint8_t*)"frames", SHM_NO_CREATOR) != a) result = FAIL;
+	if (shm_get((uint8_t*)"", SHM_NO_CREATOR) != -1) result = FAIL;
+
+	mem = (uint8_t*)shm_attach(&mask, a);
+	if (mem == NULL || mask != (1 << a)) return FAIL;
+	if (mem[0] != 0 || mem[SHM_SIZE - 1] != 0) result = FAIL;
+	mem[0] = 0x5A;
+	if (shm_attach(&mask, a) != (uint32_t)mem || mem[0] != 0x5A) result = FAIL;	// attaching again keeps the data
+
+	if (shm_detach(&mask, b) != -1) result = FAIL;	// never attached
+	if (shm_attach(&mask, b) == 0) result = FAIL;
+	if (shm_detach(&mask, a) != 0 || shm_detach(&mask, b) != 0 || mask != 0) result = FAIL;
+	if (shm_attach(&mask, a) != 0) result = FAIL;	// freed with its last detach
+
+	// a creator that halts frees what it named but nobody attached
+	a = shm_get((uint8_t*)"orphan", MAX_PROCESSES - 1);
+	b = shm_get((uint8_t*)"adopted", MAX_PROCESSES - 1);
+	if (a == -1 || b == -1 || shm_attach(&mask, b) == 0) return FAIL;
+	shm_exit(MAX_PROCESSES - 1);
+	if (shm_attach(&mask, a) != 0) result = FAIL;
+	if (shm_get((uint8_t*)"adopted", SHM_NO_CREATOR) != b) result = FAIL;	// attached, so it stays
+	if (shm_detach(&mask, b) != 0 || mask != 0) result = FAIL;
+	return result;
+}
+
+/* test_proc_enter
+ * 
+ * Makes an unused pid slot the running process, with one present image
+ * page, so code that works on the current process can run before the shell
+ * Inputs: pid -- unused process slot
+ * Outputs: None
+ * Side Effects: sets current_pid, maps pid's program memory, call with interrupts off
+ */
+static void test_proc_enter(int32_t pid){
+	create_pcb(pid);
+	user_pages_init(pid, USER_IMAGE_ADDR + USER_PAGE_SIZE, USER_IMAGE_ADDR + USER_PAGE_SIZE);
+	map_program_mem(pid);
+	current_pid = pid;
+}
+
+/* test_proc_leave
+ * 
+ * Undoes test_proc_enter
+ * Inputs: pid -- slot passed to test_proc_enter
+ * Outputs: None
+ * Side Effects: releases pid's program memory, no process is running afterwards
+ */
+static void test_proc_leave(int32_t pid){
+	user_pages_release(pid);
+	current_pid = -1;
+}
+
+/* Futex Shared Memory Test
+ * 
+ * Asserts that a word in an attached shared memory segment is a valid futex,
+ * keyed by the segment's frame and never treated as copy-on-write program memory
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: attaches and detaches a shared memory segment in an unused pid slot
+ * Coverage: futex_lookup, futex_wake, user_page_touch_write
+ * Files: futex.c/h, paging.c/h
+ */
+int futex_shm_test(){
+	TEST_HEADER;
+	int32_t pid = MAX_PROCESSES - 2;
+	uint32_t flags, addr;
+	int32_t id;
+	int result = PASS;
+
+	cli_and_save(flags);
+	test_proc_enter(pid);
+	id = shm_get((uint8_t*)"futex shm", SHM_NO_CREATOR);
+	if (id == -1 || 0 == (addr = shm_attach(&pcb_array[pid]->shm_mask, id))) {
+		result = FAIL;
+	} else {
+		if (futex_lookup((uint32_t*)(addr + 0x1234)) != (((SHM_FRAME_BASE + id) << 22) | 0x1234)) result = FAIL;
+		if (futex_lookup((uint32_t*)(addr + SHM_SIZE - 4)) == 0) result = FAIL;
+		if (futex_wake((uint32_t*)addr, 1) != 0) result = FAIL;	// valid word, nobody waiting
+		if (futex_wake((uint32_t*)(addr + 2), 1) != -1) result = FAIL;	// not aligned
+		shm_detach(&pcb_array[pid]->shm_mask, id);
+	}
+	test_proc_leave(pid);
+	restore_flags(flags);
+	return result;
+}
+
+/* Futex Key Test
+ * 
+ * Asserts that two processes attached to the same shared memory word get the
+ * same key while their private words at the same address do not, and that
+ * futex_wake wakes at most n waiters on that key only
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: attaches and detaches a shared memory segment in two unused pid slots
+ * Coverage: futex_lookup, futex_wake, futex_cancel
+ * Files: futex.c/h
+ */
+int futex_key_test(){
+	TEST_HEADER;
+	int32_t a = MAX_PROCESSES - 2, b = MAX_PROCESSES - 1;
+	uint32_t flags, addr, shm_key, priv_key;
+	int32_t id;
+	int result = PASS;
+
+	cli_and_save(flags);
+	test_proc_enter(a);
+	if (futex_lookup((uint32_t*)0x400000) != 0) result = FAIL;	// kernel memory
+	if (futex_lookup((uint32_t*)(USER_IMAGE_ADDR + 1)) != 0) result = FAIL;	// not aligned
+	id = shm_get((uint8_t*)"futex", SHM_NO_CREATOR);
+	if (id == -1 || 0 == (addr = shm_attach(&pcb_array[a]->shm_mask, id))) {
+		test_proc_leave(a);
+		restore_flags(flags);
+		return FAIL;
+	}
+	shm_key = futex_lookup((uint32_t*)addr);
+	priv_key = futex_lookup((uint32_t*)USER_IMAGE_ADDR);
+	if (shm_key == 0 || priv_key == 0) result = FAIL;
+
+	test_proc_enter(b);
+	if (shm_attach(&pcb_array[b]->shm_mask, id) != addr) result = FAIL;
+	if (futex_lookup((uint32_t*)addr) != shm_key) result = FAIL;	// same word, same key
+	if (futex_lookup((uint32_t*)(addr + 4)) == shm_key) result = FAIL;
+	if (futex_lookup((uint32_t*)USER_IMAGE_ADDR) == priv_key) result = FAIL;	// private words differ
+
+	futex_key[a] = shm_key;
+	futex_key[b] = shm_key;
+	if (futex_wake((uint32_t*)(addr + 4), MAX_PROCESSES) != 0) result = FAIL;
+	if (futex_wake((uint32_t*)addr, 1) != 1) result = FAIL;
+	if (futex_wake((uint32_t*)addr, MAX_PROCESSES) != 1) result = FAIL;
+	if (futex_wake((uint32_t*)addr, MAX_PROCESSES) != 0 || futex_key[a] != 0 || futex_key[b] != 0) result = FAIL;
+	futex_key[a] = shm_key;
+	futex_cancel(a);
+	if (futex_wake((uint32_t*)addr, 1) != 0) result = FAIL;
+	if (futex_wake((uint32_t*)addr, -1) != -1) result = FAIL;
+
+	shm_detach(&pcb_array[b]->shm_mask, id);
+	shm_detach(&pcb_array[a]->shm_mask, id);
+	user_pages_release(a);
+	test_proc_leave(b);
+	restore_flags(flags);
+	return result;
+}
+
+/* COW Fork Test
+ * 
+ * Forks one spare pid slot into the other and asserts that a write fault
+ * gives the writer a frame of its own, that an owner writing moves the sharer
+ * out, and that releasing the owner does too, with the data intact each time
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: None
+ * Coverage: user_pages_fork, user_page_fault, cow_evict_sharers, user_pages_release
+ * Files: paging.c/h
+ */
+int cow_fork_test(){
+	TEST_HEADER;
+	int32_t parent = MAX_PROCESSES - 2, child = MAX_PROCESSES - 1;
+	uint32_t* word = (uint32_t*)USER_IMAGE_ADDR;
+	uint32_t flags, parent_phys, child_phys;
+	int result = PASS;
+
+	cli_and_save(flags);
+	test_proc_enter(parent);
+	*word = 0x1234;
+	parent_phys = user_virt_to_phys((uint32_t)word);
+	create_pcb(child);
+	user_pages_fork(parent, child);
+
+	// the sharer writing copies the page into its own frame
+	current_pid = child;
+	map_program_mem(child);
+	if (user_virt_to_phys((uint32_t)word) != parent_phys) result = FAIL;
+	if (user_page_fault((uint32_t)word, PF_WRITE) != 0) result = FAIL;
+	child_phys = user_virt_to_phys((uint32_t)word);
+	if (child_phys == 0 || child_phys == parent_phys || *word != 0x1234) result = FAIL;
+	*word = 0x5678;
+
+	// the owner keeps its page and its data
+	current_pid = parent;
+	map_program_mem(parent);
+	if (*word != 0x1234) result = FAIL;
+	if (user_page_fault((uint32_t)word, PF_WRITE) != 0 || user_virt_to_phys((uint32_t)word) != parent_phys) result = FAIL;
+	if (user_page_fault((uint32_t)word, PF_WRITE) != -1) result = FAIL;	// writable now, a real fault
+
+	// the owner writing first moves the sharer to a copy
+	user_pages_fork(parent, child);
+	if (user_page_fault((uint32_t)word, PF_WRITE) != 0 || user_virt_to_phys((uint32_t)word) != parent_phys) result = FAIL;
+	*word = 0x9ABC;
+	current_pid = child;
+	map_program_mem(child);
+	if (user_virt_to_phys((uint32_t)word) != child_phys || *word != 0x1234) result = FAIL;
+
+	// releasing the owner moves the sharer out as well
+	current_pid = parent;
+	map_program_mem(parent);
+	user_pages_fork(parent, child);
+	user_pages_release(parent);
+	current_pid = child;
+	map_program_mem(child);
+	if (user_virt_to_phys((uint32_t)word) != child_phys || *word != 0x9ABC) result = FAIL;
+	if (user_page_fault((uint32_t)word, PF_WRITE) != -1) result = FAIL;	// its own page, no longer shared
+
+	test_proc_leave(child);
+	restore_flags(flags);
+	return result;
+}
+
+/* Pipe Test
+ * 
+ * Drives both ends of a pipe from a spare pid slot: data comes out in order,
+ * each extra reference keeps an end open, the last writer leaving gives end
+ * of file, the last reader leaving makes writes fail, a non-blocking writer
+ * stops at a full ring, and a pipe with no ends left is handed out again
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: None
+ * Coverage: pipe_alloc, pipe_ref, pipe_read, pipe_write, the close and poll functions
+ * Files: pipe.c/h
+ */
+int pipe_test(){
+	TEST_HEADER;
+	int32_t pid = MAX_PROCESSES - 2;
+	int32_t rd = 2, wr = 3;	// fds the test points at the two ends
+	uint8_t chunk[64];
+	uint32_t flags;
+	int32_t idx, n, total;
+	int result = PASS;
+
+	cli_and_save(flags);
+	test_proc_enter(pid);
+	if (-1 == (idx = pipe_alloc())) {
+		test_proc_leave(pid);
+		restore_flags(flags);
+		return FAIL;
+	}
+	pcb_array[pid]->fdarray[rd].inode_num = idx;
+	pcb_array[pid]->fdarray[wr].inode_num = idx;
+	pcb_array[pid]->fdarray[wr].nonblock = 1;
+
+	if (pipe_write(wr, "abc", 3) != 3) result = FAIL;
+	if (pipe_read_poll(rd, 0) != POLLIN) result = FAIL;
+	if (pipe_read(rd, chunk, sizeof(chunk)) != 3 || strncmp((int8_t*)chunk, "abc", 3)) result = FAIL;
+
+	// a second writer keeps the pipe open after the first closes
+	pipe_ref(idx, 1);
+	pipe_write_close(wr);
+	if (pipe_read_poll(rd, 0) != 0) result = FAIL;	// empty, a writer is left
+	pipe_write_close(wr);
+	if (pipe_read_poll(rd, 0) != POLLIN || pipe_read(rd, chunk, sizeof(chunk)) != 0) result = FAIL;	// end of file
+	pipe_read_close(rd);
+	if (pipe_alloc() != idx) result = FAIL;	// no ends left, free again
+
+	// a non-blocking writer fills the ring and then gets -EAGAIN
+	for (total = 0; (n = pipe_write(wr, chunk, sizeof(chunk))) > 0; total += n);
+	if (n != -EAGAIN || total != PIPE_SIZE || pipe_write_poll(wr, 0) != 0) result = FAIL;
+
+	// with no reader left a write fails at once
+	pipe_read_close(rd);
+	if (pipe_write_poll(wr, 0) != POLLOUT || pipe_write(wr, "x", 1) != -1) result = FAIL;
+	pipe_write_close(wr);
+
+	pcb_array[pid]->fdarray[wr].nonblock = 0;
+	test_proc_leave(pid);
+	restore_flags(flags);
+	return result;
+}
+
+/* User Range Test
+ * 
+ * Reserves, finds and releases lazy ranges in an unused process slot
+ * without touching them
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: None
+ * Coverage: user_range_reserve, user_range_find, user_range_release
+ * Files: paging.c/h
+ */
+int user_range_test(){
+	TEST_HEADER;
+	int32_t pid = MAX_PROCESSES - 1;
+	uint32_t heap = USER_IMAGE_ADDR + 0x10 * USER_PAGE_SIZE;
+	uint32_t addr;
+	int result = PASS;
+
+	if (user_range_reserve(pid, heap, heap + 2 * USER_PAGE_SIZE, 0) != 0) result = FAIL;
+	if (user_range_reserve(pid, heap + USER_PAGE_SIZE, heap + 3 * USER_PAGE_SIZE, 0) != -1) result = FAIL;	// overlaps
+	if (user_range_reserve(pid, USRMEM_TOP - USER_PAGE_SIZE, USRMEM_TOP, 1) != -1) result = FAIL;	// stack region
+
+	addr = user_range_find(pid, 4);
+	if (addr == 0 || addr + 4 * USER_PAGE_SIZE != USRMEM_TOP - USER_STACK_PAGES * USER_PAGE_SIZE) result = FAIL;
+	if (user_range_reserve(pid, addr, addr + 4 * USER_PAGE_SIZE, 1) != 0) result = FAIL;
+	if (user_range_find(pid, 1) != addr - USER_PAGE_SIZE) result = FAIL;
+
+	if (user_range_release(pid, heap, heap + USER_PAGE_SIZE, 1) != -1) result = FAIL;	// heap is not a mapping
+	if (user_range_release(pid, addr, addr + 4 * USER_PAGE_SIZE, 1) != 0) result = FAIL;
+	user_range_release(pid, heap, heap + 2 * USER_PAGE_SIZE, 0);
+	if (user_range_find(pid, 4) != addr) result = FAIL;
+	return result;
+}
+
+
+/* File Block Test
+ * 
+ * Asserts that the blocks handed out for mapping a file hold what
+ * read_data reads and that there are none past the end of the file
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: None
+ * Coverage: file_block
+ * Files: file_system.c/h
+ */
+int file_block_test(){
+	TEST_HEADER;
+	dentry_t entry;
+	data_block_t* block;
+	uint8_t buf[64];
+	int32_t size, n;
+	int result = PASS;
+
+	if (read_dentry_by_name((uint8_t*)"frame0.txt", &entry) != 0) return FAIL;
+	size = get_file_size(entry.inode_num);
+
+	block = file_block(entry.inode_num, 0);
+	n = read_data(entry.inode_num, 0, buf, sizeof(buf));
+	if (block == NULL || n <= 0 || strncmp(block->byte, (int8_t*)buf, n) != 0) result = FAIL;
+	if (file_block(entry.inode_num, (size + BLOCK_BYTE_SIZE - 1) / BLOCK_BYTE_SIZE) != NULL) result = FAIL;
+	return result;
+}
+
+
+/* Read Data Offset Test
+ * 
+ * Asserts that read_data starts where it is told, as pread relies on, and
+ * reads nothing at or past the end of the file
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: None
+ * Coverage: read_data
+ * Files: file_system.c/h
+ */
+int read_data_offset_test(){
+	TEST_HEADER;
+	dentry_t entry;
+	uint8_t whole[64], part[32];
+	int32_t size;
+	int result = PASS;
+
+	if (read_dentry_by_name((uint8_t*)"frame0.txt", &entry) != 0) return FAIL;
+	size = get_file_size(entry.inode_num);
+
+	if (read_data(entry.inode_num, 0, whole, sizeof(whole)) != sizeof(whole)) return FAIL;
+	if (read_data(entry.inode_num, 16, part, sizeof(part)) != sizeof(part)) result = FAIL;
+	if (strncmp((int8_t*)whole + 16, (int8_t*)part, sizeof(part)) != 0) result = FAIL;
+	if (read_data(entry.inode_num, size, part, sizeof(part)) != 0) result = FAIL;
+	if (read_data(entry.inode_num, size + BLOCK_BYTE_SIZE, part, sizeof(part)) != 0) result = FAIL;
+	return result;
+}
+
+
+/* Stat Test
+ * 
+ * Asserts that stat reports a file's size, type, inode and blocks, a
+ * directory and a device by their types, and fails for a missing name or
+ * for buffers outside program memory
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: None
+ * Coverage: stat, stat_name
+ * Files: system_calls.c/h
+ */
+int stat_test(){
+	TEST_HEADER;
+	dentry_t entry;
+	stat_t st;
+	int result = PASS;
+
+	if (read_dentry_by_name((uint8_t*)"frame0.txt", &entry) != 0) return FAIL;
+	if (stat_name((uint8_t*)"frame0.txt", &st) != 0) return FAIL;
+	if (st.type != STAT_FILE || st.inode != entry.inode_num || st.size != get_file_size(entry.inode_num)) result = FAIL;
+	if (st.blocks != (st.size + BLOCK_BYTE_SIZE - 1) / BLOCK_BYTE_SIZE) result = FAIL;
+
+	if (stat_name((uint8_t*)".", &st) != 0 || st.type != STAT_DIR || st.size != 0) result = FAIL;
+	if (stat_name((uint8_t*)"rtc", &st) != 0 || st.type != STAT_RTC) result = FAIL;
+	if (stat_name((uint8_t*)"no such file", &st) != -1) result = FAIL;
+	if (stat((uint8_t*)"frame0.txt", &st) != -1) result = FAIL;	// kernel buffers
+	return result;
+}
+
 
 /* Test suite entry point */
 void launch_tests(){
@@ -611,5 +1354,24 @@ void launch_tests(){
 
 	//TEST_OUTPUT("terminal test", terminal_test());
 	//TEST_OUTPUT("garbage terminal test", garbage_terminal_test());
+
+	/* Performance tests */
+
+	//TEST_OUTPUT("irq stats test", irq_stats_test());
+	//TEST_OUTPUT("terminal throughput test", terminal_throughput_test());
+	//TEST_OUTPUT("scrollback test", scrollback_test());
+	//TEST_OUTPUT("history test", history_test());
+	//TEST_OUTPUT("keyboard ring test", kbd_ring_test());
+	//TEST_OUTPUT("input device test", input_dev_test());
+	//TEST_OUTPUT("poll readiness test", poll_ready_test());
+	//TEST_OUTPUT("shared memory test", shm_test());
+	//TEST_OUTPUT("futex key test", futex_key_test());
+	//TEST_OUTPUT("futex shared memory test", futex_shm_test());
+	//TEST_OUTPUT("cow fork test", cow_fork_test());
+	//TEST_OUTPUT("pipe test", pipe_test());
+	//TEST_OUTPUT("user range test", user_range_test());
+	//TEST_OUTPUT("file block test", file_block_test());
+	//TEST_OUTPUT("read data offset test", read_data_offset_test());
+	//TEST_OUTPUT("stat test", stat_test());
 }
 
@@ -7,6 +7,9 @@
 #define PAGE_SIZE (VMEM + 4096)
 #define FILEBUFSIZE 1024
 #define SBUFSIZE 33
+#define THROUGHPUT_BUFSIZE 8192
+#define THROUGHPUT_ROUNDS 16
+#define RTC_CALIBRATE_TICKS 256
 
 // test launcher
 void launch_tests();
@@ -0,0 +1,112 @@
+#include "wait_queue.h"
+#include "lib.h"
+#include "klog.h"
+
+extern int8_t current_pid;
+
+volatile uint32_t sleeping_pids = 0;
+
+
+/* wait_queue_sleep
+ *
+ * marks the running process asleep on wq and halts until something wakes it.
+ * The pit skips sleeping processes, so other terminals get the cpu meanwhile.
+ * sti;hlt cannot lose an interrupt between the two, so a wake_up that comes
+ * after the caller checked its condition is never missed
+ * Inputs: wq -- queue to sleep on
+ * Outputs: None
+ * Side Effects: returns with interrupts off
+ */
+void wait_queue_sleep(wait_queue_t* wq){
+    if (wq == NULL) return;
+
+    cli();
+    wait_queue_add(wq);
+    wait_queue_block();
+}
+
+/* wait_queue_add
+ *
+ * puts the running process on wq without sleeping yet, so it can wait on
+ * several queues at once. A wake_up on any of them ends the next
+ * wait_queue_block, the bits left on the others only cause a spurious wakeup
+ * Inputs: wq -- queue to wait on
+ * Outputs: None
+ * Side Effects: call with interrupts off
+ */
+void wait_queue_add(wait_queue_t* wq){
+    int8_t pid = current_pid;
+
+    if (wq == NULL || pid < 0) return;
+    wq->waiters |= 1 << pid;
+}
+
+/* wait_queue_block
+ *
+ * sleeps until a wake_up on one of the queues the running process was added to.
+ * With no process running it only waits for one interrupt, callers recheck anyway
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: call with interrupts off, returns with interrupts off
+ */
+void wait_queue_block(void){
+    int8_t pid = current_pid;
+    uint32_t bit;
+
+    if (pid < 0) { //nothing to schedule instead, just wait for the next interrupt
+        asm volatile ("sti; hlt; cli" ::: "memory");
+        return;
+    }
+    bit = 1 << pid;
+
+    sleeping_pids |= bit;
+    while (sleeping_pids & bit) {
+        if (klog_flush()) continue; // idle time goes to the kernel log first
+        asm volatile ("sti; hlt; cli" ::: "memory");
+    }
+}
+
+/* wake_up
+ *
+ * wakes every process sleeping on wq, safe to call from interrupts
+ * Inputs: wq -- queue to wake
+ * Outputs: None
+ * Side Effects: None
+ */
+void wake_up(wait_queue_t* wq){
+    uint32_t flags;
+    if (wq == NULL) return;
+
+    cli_and_save(flags);
+    sleeping_pids &= ~wq->waiters;
+    wq->waiters = 0;
+    restore_flags(flags);
+}
+
+/* pid_sleeping
+ *
+ * Inputs: pid -- process to check
+ * Outputs: nonzero if it is asleep on a wait queue
+ * Side Effects: None
+ */
+uint32_t pid_sleeping(int32_t pid){
+    if (pid < 0) return 0;
+    return sleeping_pids & (1 << pid);
+}
+
+/* wait_queue_cancel
+ *
+ * forgets that pid is asleep, for a process that is ended while it sleeps.
+ * Bits it left on wait queues only cause a spurious wakeup of the next user of the pid
+ * Inputs: pid -- process being ended
+ * Outputs: None
+ * Side Effects: None
+ */
+void wait_queue_cancel(int32_t pid){
+    uint32_t flags;
+    if (pid < 0) return;
+
+    cli_and_save(flags);
+    sleeping_pids &= ~(1 << pid);
+    restore_flags(flags);
+}
@@ -0,0 +1,31 @@
+#ifndef _WAIT_QUEUE_H
+#define _WAIT_QUEUE_H
+
+#include "types.h"
+
+/* processes waiting for something, one bit per pid */
+typedef struct wait_queue_t {
+    volatile uint32_t waiters;
+} wait_queue_t;
+
+/* pids that are asleep on some wait queue, the scheduler skips these */
+extern volatile uint32_t sleeping_pids;
+
+/* puts the current process to sleep on wq until a wake_up. Call with
+ * interrupts off after checking the condition, and check it again after */
+void wait_queue_sleep(wait_queue_t* wq);
+
+/* the two halves of wait_queue_sleep, for waiting on more than one queue */
+void wait_queue_add(wait_queue_t* wq);
+void wait_queue_block(void);
+
+/* wakes everything sleeping on wq */
+void wake_up(wait_queue_t* wq);
+
+/* nonzero if pid is asleep */
+uint32_t pid_sleeping(int32_t pid);
+
+/* marks pid awake for good, it is being ended in its sleep */
+void wait_queue_cancel(int32_t pid);
+
+#endif /* _WAIT_QUEUE_H */
@@ -18,6 +18,11 @@ int main ()
 	return 2;
     }
 
+    /* let the kernel stream it, fall back to copying if it cannot */
+    while (0 < (cnt = ece391_sendfile (1, fd, 0x10000)));
+    if (0 == cnt)
+        return 0;
+
     while (0 != (cnt = ece391_read (fd, buf, 1024))) {
         if (-1 == cnt) {
 	    ece391_fdputs (1, (uint8_t*)"file read failed\n");
@@ -0,0 +1,86 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+#define RTC_FREQ        32
+#define CALIB_TICKS     16      /* half a second of RTC ticks */
+#define CALIB_US        500000
+#define NUM_EVENTS      8       /* most events taken per read */
+#define QUIT_CODE       0x10    /* 'q' */
+
+/* low 32 bits of the TSC are enough for anything under a second */
+static uint32_t rdtsc32 (void)
+{
+    uint32_t lo, hi;
+    asm volatile ("rdtsc" : "=a"(lo), "=d"(hi));
+    return lo;
+}
+
+static void put_num (uint32_t n, int32_t radix)
+{
+    uint8_t buf[16];
+    ece391_itoa(n, buf, radix);
+    ece391_fdputs(1, buf);
+}
+
+/*
+ * Times the RTC against the TSC to get cycles per microsecond, then prints
+ * how long each key event took from the keyboard interrupt to this program.
+ */
+int main ()
+{
+    input_event_t ev[NUM_EVENTS];
+    uint32_t start, now, cycles_per_us, lat;
+    int32_t rtc_fd, kbd_fd, cnt, i, garbage;
+
+    /* keys still land in the terminal too, keep them off the screen */
+    ece391_ioctl(0, TERM_SETMODE, TERM_MODE_RAW);
+
+    rtc_fd = ece391_open((uint8_t*)"rtc");
+    garbage = RTC_FREQ;
+    if (-1 == rtc_fd || -1 == ece391_write(rtc_fd, &garbage, 4)) {
+        ece391_fdputs(1, (uint8_t*)"Can't open rtc\n");
+        return 2;
+    }
+    ece391_read(rtc_fd, &garbage, 4);
+    start = rdtsc32();
+    for (i = 0; i < CALIB_TICKS; i++)
+        ece391_read(rtc_fd, &garbage, 4);
+    now = rdtsc32();
+    ece391_close(rtc_fd);
+    cycles_per_us = (now - start) / CALIB_US;
+    if (cycles_per_us == 0)
+        cycles_per_us = 1;
+
+    if (-1 == (kbd_fd = ece391_open((uint8_t*)"keyboard"))) {
+        ece391_fdputs(1, (uint8_t*)"Can't open keyboard device\n");
+        return 2;
+    }
+    put_num(cycles_per_us, 10);
+    ece391_fdputs(1, (uint8_t*)" cycles/us, press keys, q quits\n");
+
+    while (1) {
+        cnt = ece391_read(kbd_fd, ev, sizeof(ev));
+        now = rdtsc32();
+        if (cnt <= 0)
+            break;
+        for (i = 0; i < cnt / (int32_t)sizeof(input_event_t); i++) {
+            if (ev[i].code == QUIT_CODE) {
+                ece391_close(kbd_fd);
+                return 0;
+            }
+            lat = now - ev[i].time_lo;
+            ece391_fdputs(1, (uint8_t*)"code 0x");
+            put_num(ev[i].code, 16);
+            ece391_fdputs(1, (uint8_t*)": ");
+            put_num(lat, 10);
+            ece391_fdputs(1, (uint8_t*)" cycles, ");
+            put_num(lat / cycles_per_us, 10);
+            ece391_fdputs(1, (uint8_t*)" us\n");
+        }
+    }
+
+    ece391_close(kbd_fd);
+    return 0;
+}
@@ -4,25 +4,55 @@
 #include "ece391syscall.h"
 
 #define SBUFSIZE 33
+#define NDIRENTS 63     /* a directory never has more entries than this */
 
-int main ()
+/* lists the directory one entry per read, for when getdents is not there */
+int32_t
+list_by_read (int32_t fd)
 {
-    int32_t fd, cnt;
+    int32_t cnt;
     uint8_t buf[SBUFSIZE];
 
+    while (0 != (cnt = ece391_read (fd, buf, SBUFSIZE-1))) {
+        if (-1 == cnt) {
+	        ece391_fdputs (1, (uint8_t*)"directory entry read failed\n");
+	        return 3;
+	    }
+	    buf[cnt] = '\n';
+	    if (-1 == ece391_write (1, buf, cnt + 1))
+	        return 3;
+    }
+    return 0;
+}
+
+int main ()
+{
+    int32_t fd, cnt, i, len;
+    struct dirent ents[NDIRENTS];
+    uint8_t out[NDIRENTS * SBUFSIZE];
+
     if (-1 == (fd = ece391_open ((uint8_t*)"."))) {
         ece391_fdputs (1, (uint8_t*)"directory open failed\n");
         return 2;
     }
 
-    while (0 != (cnt = ece391_read (fd, buf, SBUFSIZE-1))) {
+    /* the whole listing in one getdents, printed with one write */
+    if (-1 == (cnt = ece391_getdents (fd, ents, sizeof (ents))))
+        return list_by_read (fd);
+
+    while (0 != cnt) {
         if (-1 == cnt) {
 	        ece391_fdputs (1, (uint8_t*)"directory entry read failed\n");
 	        return 3;
 	    }
-	    buf[cnt] = '\n';
-	    if (-1 == ece391_write (1, buf, cnt + 1))
+	    for (len = 0, i = 0; i < cnt / (int32_t)sizeof (struct dirent); i++) {
+	        ece391_strcpy (out + len, ents[i].name);
+	        len += ece391_strlen (ents[i].name);
+	        out[len++] = '\n';
+	    }
+	    if (-1 == ece391_write (1, out, len))
 	        return 3;
+	    cnt = ece391_getdents (fd, ents, sizeof (ents));
     }
 
     return 0;
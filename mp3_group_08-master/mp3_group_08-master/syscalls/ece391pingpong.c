@@ -12,6 +12,20 @@
 #define STARTCHAR 'A'
 #define ENDCHAR 'Z'
 
+/* reads whatever was typed without waiting, q ends the game */
+static int32_t quit_pressed (void)
+{
+    uint8_t keys[16];
+    int32_t i, cnt;
+
+    cnt = ece391_read(0, keys, sizeof(keys));
+    for (i = 0; i < cnt; i++) {
+	if (keys[i] == 'q')
+	    return 1;
+    }
+    return 0;
+}
+
 int main ()
 {
     int32_t i = 0;
@@ -33,6 +47,11 @@ int main ()
     buf[BUFMAX-3]='|';
     buf[START]='|';
 
+    // Keys typed while it bounces should not be echoed over it, and
+    // checking for them should not cost a frame
+    ece391_ioctl(0, TERM_SETMODE, TERM_MODE_RAW);
+    ece391_ioctl(0, F_SETFL, O_NONBLOCK);
+
     // Open and set RTC Frequency
     rtc_fd = ece391_open((uint8_t*)"rtc");
     ret_val = 32;
@@ -55,6 +74,8 @@ int main ()
 
 		// Wait for RTC tick
 		ece391_read(rtc_fd, &garbage, 4);
+		if (quit_pressed())
+			return 0;
 	}
 	
 	// Bounce back
@@ -72,6 +93,8 @@ int main ()
 
 		// Wait for RTC tick
 		ece391_read(rtc_fd, &garbage, 4);
+		if (quit_pressed())
+			return 0;
     	}
 
 	// Edge case on characters
@@ -4,14 +4,82 @@
 #include "ece391syscall.h"
 
 #define BUFSIZE 1024
+#define SAVE_STDIN  6   /* where the shell keeps its own stdin/stdout */
+#define SAVE_STDOUT 7   /* while a pipeline borrows fds 0 and 1 */
+
+/* drops the spaces around a command in place */
+static uint8_t*
+trim (uint8_t* s)
+{
+    int32_t len;
+
+    while (' ' == *s)
+        s++;
+    len = ece391_strlen (s);
+    while (len > 0 && ' ' == s[len - 1])
+        s[--len] = '\0';
+    return s;
+}
+
+/*
+ * runs "left | right": left is spawned with its stdout on a pipe and right
+ * is executed with its stdin on the other end, so it sees end of file once
+ * left halts. Returns right's status, or -1 if either could not start.
+ */
+static int32_t
+run_pipeline (uint8_t* left, uint8_t* right)
+{
+    int32_t p[2], pid, rval;
+
+    if ('\0' == *left || '\0' == *right || -1 == ece391_pipe (p))
+        return -1;
+
+    ece391_dup2 (1, SAVE_STDOUT);
+    ece391_dup2 (p[1], 1);
+    pid = ece391_spawn (left);
+    ece391_dup2 (SAVE_STDOUT, 1);
+    ece391_close (SAVE_STDOUT);
+    ece391_close (p[1]);
+    if (-1 == pid) {
+        ece391_close (p[0]);
+        return -1;
+    }
+
+    ece391_dup2 (0, SAVE_STDIN);
+    ece391_dup2 (p[0], 0);
+    ece391_close (p[0]);
+    rval = ece391_execute (right);
+    ece391_dup2 (SAVE_STDIN, 0);
+    ece391_close (SAVE_STDIN);
+    /* with right gone nothing reads the pipe, so left fails its next write and ends */
+    ece391_wait (pid, 0, 0);
+    return rval;
+}
+
+/* prints "[pid] msg" for a background job */
+static void
+job_note (int32_t pid, const char* msg)
+{
+    uint8_t num[12];
+
+    ece391_fdputs (1, (uint8_t*)"[");
+    ece391_fdputs (1, ece391_itoa (pid, num, 10));
+    ece391_fdputs (1, (uint8_t*)"] ");
+    ece391_fdputs (1, (uint8_t*)msg);
+    ece391_fdputs (1, (uint8_t*)"\n");
+}
 
 int main ()
 {
-    int32_t cnt, rval;
+    int32_t cnt, rval, bar, pid, status;
     uint8_t buf[BUFSIZE];
+    uint8_t* cmd;
     ece391_fdputs (1, (uint8_t*)"Starting 391 Shell\n");
 
     while (1) {
+        /* collect background jobs that finished while the last command ran */
+        while (0 < (pid = ece391_wait (-1, &status, WNOHANG)))
+            job_note (pid, (0 == status) ? "done" : "exited abnormally");
         ece391_fdputs (1, (uint8_t*)"391OS> ");
 	if (-1 == (cnt = ece391_read (0, buf, BUFSIZE-1))) {
 	    ece391_fdputs (1, (uint8_t*)"read from keyboard failed\n");
@@ -20,11 +88,28 @@ int main ()
 	if (cnt > 0 && '\n' == buf[cnt - 1])
 	    cnt--;
 	buf[cnt] = '\0';
-	if (0 == ece391_strcmp (buf, (uint8_t*)"exit"))
+	cmd = trim (buf);
+	if (0 == ece391_strcmp (cmd, (uint8_t*)"exit"))
 	    return 0;
-	if ('\0' == buf[0])
+	if ('\0' == cmd[0])
+	    continue;
+	cnt = ece391_strlen (cmd);
+	if (cnt > 0 && '&' == cmd[cnt - 1]) {
+	    /* background job, the shell takes the next command right away */
+	    cmd[cnt - 1] = '\0';
+	    if ('\0' == *(cmd = trim (cmd)) || -1 == (pid = ece391_spawn (cmd)))
+		ece391_fdputs (1, (uint8_t*)"no such command\n");
+	    else
+		job_note (pid, "started");
 	    continue;
-	rval = ece391_execute (buf);
+	}
+	for (bar = 0; '\0' != cmd[bar] && '|' != cmd[bar]; bar++);
+	if ('|' == cmd[bar]) {
+	    cmd[bar] = '\0';
+	    rval = run_pipeline (trim (cmd), trim (cmd + bar + 1));
+	} else {
+	    rval = ece391_execute (cmd);
+	}
 	if (-1 == rval)
 	    ece391_fdputs (1, (uint8_t*)"no such command\n");
 	else if (256 == rval)
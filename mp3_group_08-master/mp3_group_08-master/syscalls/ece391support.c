@@ -102,3 +102,58 @@ uint8_t* ece391_strrev(uint8_t* s)
    return s;
 }
 
+
+/* Atomic compare-and-swap, returns what *m held before */
+static uint32_t cmpxchg(ece391_mutex_t* m, uint32_t old, uint32_t new)
+{
+    uint32_t prev;
+
+    asm volatile ("lock; cmpxchgl %2, %1"
+                  : "=a" (prev), "+m" (*m)
+                  : "r" (new), "0" (old)
+                  : "memory");
+    return prev;
+}
+
+/* Atomic exchange, returns what *m held before */
+static uint32_t xchg(ece391_mutex_t* m, uint32_t new)
+{
+    asm volatile ("xchgl %0, %1"
+                  : "+r" (new), "+m" (*m)
+                  :
+                  : "memory");
+    return new;
+}
+
+/* Take the lock, sleeping in the kernel only while someone else holds it */
+void ece391_mutex_lock(ece391_mutex_t* m)
+{
+    uint32_t c;
+
+    if (0 == (c = cmpxchg(m, 0, 1)))
+        return;
+    /* mark it contended so the holder knows to wake us */
+    if (2 != c)
+        c = xchg(m, 2);
+    while (0 != c) {
+        ece391_futex_wait((uint32_t*)m, 2);
+        c = xchg(m, 2);
+    }
+}
+
+/* Release the lock, waking one waiter if there are any */
+void ece391_mutex_unlock(ece391_mutex_t* m)
+{
+    if (2 == xchg(m, 0))
+        ece391_futex_wake((uint32_t*)m, 1);
+}
+
+/* Move the program break by incr bytes, returns the old break or -1 */
+void* ece391_sbrk(int32_t incr)
+{
+    int32_t old = ece391_brk(0);
+
+    if (-1 == old || -1 == ece391_brk(old + incr))
+        return (void*)-1;
+    return (void*)old;
+}
@@ -9,5 +9,14 @@ extern int32_t ece391_strncmp(const uint8_t* s1, const uint8_t* s2, uint32_t n);
 extern uint8_t *ece391_itoa(uint32_t value, uint8_t* buf, int32_t radix);
 extern uint8_t *ece391_strrev(uint8_t* s);
 
+/* a lock word, 0 unlocked, 1 locked, 2 locked with processes waiting; it
+ * may live in shared memory. Taking a free lock never enters the kernel. */
+typedef volatile uint32_t ece391_mutex_t;
+extern void ece391_mutex_lock(ece391_mutex_t* m);
+extern void ece391_mutex_unlock(ece391_mutex_t* m);
+
+/* grows or shrinks the heap, the new memory reads as zeros */
+extern void* ece391_sbrk(int32_t incr);
+
 #endif /* ECE391SUPPORT_H */
 
@@ -11,5 +11,28 @@
 #define SYS_VIDMAP  8
 #define SYS_SET_HANDLER  9
 #define SYS_SIGRETURN  10
+#define SYS_IOCTL   11
+#define SYS_POLL    12
+#define SYS_PIPE    13
+#define SYS_DUP2    14
+#define SYS_SPAWN   15
+#define SYS_SHMGET  16
+#define SYS_SHMAT   17
+#define SYS_SHMDT   18
+#define SYS_FUTEX_WAIT  19
+#define SYS_FUTEX_WAKE  20
+#define SYS_THREAD_CREATE  21
+#define SYS_WAIT    22
+#define SYS_FORK    23
+#define SYS_BRK     24
+#define SYS_MMAP    25
+#define SYS_MUNMAP  26
+#define SYS_SENDFILE 27
+#define SYS_LSEEK   28
+#define SYS_PREAD   29
+#define SYS_PWRITE  30
+#define SYS_STAT    31
+#define SYS_FSTAT   32
+#define SYS_GETDENTS 33
 
 #endif /* ECE391SYSNUM_H */